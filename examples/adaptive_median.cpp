@@ -44,6 +44,7 @@ options_t::options_t (int argc, char** argv) {
 
     desc_->add (generic);
     desc_->add (config);
+    desc_->add (loop_options ());
 
     store (po::command_line_parser (argc, argv).options (*desc_).run (), map_);
 
@@ -90,15 +91,15 @@ process_adaptive_median (cv::VideoCapture& cap, const options_t& opts) {
         opts ["frame-interval"].as< size_t > (),
         opts ["threshold"].as< size_t > ());
 
-    for (auto& frame : bs::getframes_from (cap)) {
-        bs::frame_delay temp { 10 };
+    frame_loop_t loop (opts);
 
-        auto mask = adaptive_median (bs::scale_frame (frame));
+    for (auto& frame : bs::getframes_from (cap)) {
+        const auto& mask = adaptive_median (bs::scale_frame (frame));
 
         if (display)
             imshow ("Adaptive median difference", mask);
 
-        if (temp.wait_for_key (27))
+        if (loop (mask))
             break;
     }
 }
@@ -0,0 +1,603 @@
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+namespace fs = boost::filesystem;
+
+#include <boost/make_shared.hpp>
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <bs/adaptive_median.hpp>
+#include <bs/arena.hpp>
+#include <bs/cpu.hpp>
+#include <bs/fgmm.hpp>
+#include <bs/frame_range.hpp>
+#include <bs/fuzzy_choquet.hpp>
+#include <bs/fuzzy_sugeno.hpp>
+#include <bs/grimson_gmm.hpp>
+#include <bs/scene.hpp>
+#include <bs/sigma_delta.hpp>
+#include <bs/simple_gaussian.hpp>
+#include <bs/temporal_median.hpp>
+#include <bs/utils.hpp>
+#include <bs/zivkovic_gmm.hpp>
+
+#include <options.hpp>
+
+#if defined (_OPENMP)
+#  include <omp.h>
+#endif // _OPENMP
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+//
+// options_t::options_t is specific to each example:
+//
+options_t::options_t (int argc, char** argv) {
+    {
+        auto tmp = std::make_pair (
+                       "program", po::variable_value (std::string (argv [0]), false));
+        map_.insert (tmp);
+    }
+
+    po::options_description generic ("Generic options");
+    po::options_description config ("Configuration options");
+
+    generic.add_options ()
+    ("version", "version")
+    ("help", "this");
+
+    config.add_options ()
+    ("input,i", po::value< std::string > ()->default_value ("."),
+     "a clip, or a directory of clips and/or frame images.")
+
+    ("scene,s", po::value< std::string > (),
+     "a synthetic scene of the given size, e.g., 640x480, with ground truth, "
+     "instead of the input.")
+
+    ("model,m", po::value< std::vector< std::string > > ()->multitoken (),
+     "models to run (all).")
+
+    ("threads,j", po::value< std::vector< size_t > > ()->multitoken ()
+     ->default_value (std::vector< size_t > { 1 }, "1"),
+     "thread counts to sweep (1).")
+
+    ("width,w", po::value< std::vector< size_t > > ()->multitoken ()
+     ->default_value (std::vector< size_t > { 0 }, "0"),
+     "frame widths to sweep, 0 is the native width (0).")
+
+    ("frames,n", po::value< size_t > ()->default_value (300),
+     "frames per clip, at most (300).")
+
+    ("warmup", po::value< size_t > ()->default_value (10),
+     "leading frames left out of the statistics (10).")
+
+    ("format,f", po::value< std::string > ()->default_value ("csv"),
+     "output format, csv or json (csv).")
+
+    ("output,o", po::value< std::string > (),
+     "output file (standard output).");
+
+    desc_ = boost::make_shared< po::options_description > ();
+
+    desc_->add (generic);
+    desc_->add (config);
+
+    store (po::command_line_parser (argc, argv).options (*desc_).run (), map_);
+
+    notify (map_);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+static void
+program_options_from (int& argc, char** argv) {
+    bool complete_invocation = false;
+
+    options_t program_options (argc, argv);
+
+    if (program_options.have ("version")) {
+        std::cout << "OpenCV v3.1\n";
+        complete_invocation = true;
+    }
+
+    if (program_options.have ("help")) {
+        std::cout << program_options.description () << std::endl;
+        complete_invocation = true;
+    }
+
+    if (complete_invocation)
+        exit (0);
+
+    global_options (program_options);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+using clock_type = std::chrono::steady_clock;
+
+using runner_type = std::function< const cv::Mat& (const cv::Mat&) >;
+
+//
+// A model under benchmark: the conversion of the frames to its input, and its
+// construction from the first converted frame:
+//
+struct bench_model_t {
+    std::string name;
+    std::function< cv::Mat (const cv::Mat&) > prepare;
+    std::function< runner_type (const cv::Mat&) > make;
+};
+
+template< typename Model, typename ... Args >
+static runner_type
+runner_from (Args&& ... args) {
+    auto p = std::make_shared< Model > (std::forward< Args > (args)...);
+
+    return [p](const cv::Mat& frame) -> const cv::Mat& {
+        return (*p) (frame);
+    };
+}
+
+static cv::Mat
+as_is (const cv::Mat& frame) {
+    return frame;
+}
+
+static cv::Mat
+as_gray (const cv::Mat& frame) {
+    return bs::gray_from (frame);
+}
+
+static const std::vector< bench_model_t >&
+bench_models () {
+    static const std::vector< bench_model_t > models {
+        { "adaptive_median", as_gray, [](const cv::Mat& b) {
+                return runner_from< bs::adaptive_median_t > (b, 10, 15); } },
+
+        { "fgmm_um", as_is, [](const cv::Mat&) {
+                return runner_from< bs::fgmm_um_t > (); } },
+
+        { "fgmm_uv", as_is, [](const cv::Mat&) {
+                return runner_from< bs::fgmm_uv_t > (); } },
+
+        { "fuzzy_choquet", as_is, [](const cv::Mat& b) {
+                return runner_from< bs::fuzzy_choquet_t > (bs::float_from (b)); } },
+
+        { "fuzzy_sugeno", as_is, [](const cv::Mat& b) {
+                return runner_from< bs::fuzzy_sugeno_t > (bs::float_from (b)); } },
+
+        { "grimson_gmm", as_is, [](const cv::Mat&) {
+                return runner_from< bs::grimson_gmm_t > (); } },
+
+        { "sigma_delta", as_gray, [](const cv::Mat& b) {
+                return runner_from< bs::sigma_delta_t > (b); } },
+
+        { "simple_gaussian", as_is, [](const cv::Mat& b) {
+                return runner_from< bs::simple_gaussian_t > (b); } },
+
+        { "temporal_median", as_gray, [](const cv::Mat& b) {
+                return runner_from< bs::temporal_median_t > (b); } },
+
+        { "zivkovic_gmm", as_is, [](const cv::Mat&) {
+                return runner_from< bs::zivkovic_gmm_t > (); } }
+    };
+
+    return models;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// A clip is a video file, the (sorted) frame images of a directory, or a
+// synthetic scene, the only one with the ground truth masks of its frames:
+//
+struct clip_t {
+    std::string name;
+    std::vector< cv::Mat > frames, truth;
+};
+
+static bool
+is_video (const fs::path& path) {
+    const auto ext = path.extension ();
+    return ext == ".avi" || ext == ".mp4" || ext == ".mpg" || ext == ".mov" ||
+        ext == ".mkv";
+}
+
+static bool
+is_image (const fs::path& path) {
+    const auto ext = path.extension ();
+    return ext == ".png" || ext == ".jpg" || ext == ".bmp" || ext == ".pgm" ||
+        ext == ".ppm" || ext == ".tif" || ext == ".tiff";
+}
+
+static clip_t
+load_video (const fs::path& path, size_t n) {
+    clip_t clip { path.filename ().string (), { }, { } };
+
+    cv::VideoCapture cap;
+
+    if (!cap.open (path.string ()))
+        return clip;
+
+    for (const auto& frame : bs::getframes_from (cap)) {
+        if (clip.frames.size () >= n)
+            break;
+
+        clip.frames.push_back (frame.clone ());
+    }
+
+    return clip;
+}
+
+static std::vector< clip_t >
+load_clips (const fs::path& input, size_t n) {
+    std::vector< clip_t > clips;
+
+    if (!fs::is_directory (input)) {
+        clips.push_back (load_video (input, n));
+        return clips;
+    }
+
+    std::vector< fs::path > videos, images;
+
+    for (const auto& entry : fs::directory_iterator (input)) {
+        if (is_video (entry.path ()))
+            videos.push_back (entry.path ());
+        else if (is_image (entry.path ()))
+            images.push_back (entry.path ());
+    }
+
+    std::sort (videos.begin (), videos.end ());
+    std::sort (images.begin (), images.end ());
+
+    for (const auto& path : videos)
+        clips.push_back (load_video (path, n));
+
+    if (!images.empty ()) {
+        clip_t clip { input.filename ().string (), { }, { } };
+
+        for (const auto& path : images) {
+            if (clip.frames.size () >= n)
+                break;
+
+            auto frame = cv::imread (path.string (), cv::IMREAD_COLOR);
+
+            if (!frame.empty ())
+                clip.frames.push_back (frame);
+        }
+
+        clips.push_back (std::move (clip));
+    }
+
+    return clips;
+}
+
+static clip_t
+make_scene (const std::string& size, size_t n) {
+    bs::scene_options_t options;
+
+    if (2 != sscanf (size.c_str (), "%dx%d", &options.size.width,
+                     &options.size.height))
+        throw std::invalid_argument ("bad scene size: " + size);
+
+    options.frames = n;
+    options.flicker = options.waving = 2;
+
+    bs::scene_t scene (options);
+
+    clip_t clip { "scene-" + size, { }, { } };
+
+    for (cv::Mat frame, truth; scene.next (frame, truth); ) {
+        clip.frames.push_back (frame.clone ());
+        clip.truth.push_back (truth.clone ());
+    }
+
+    return clip;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// The resident set size, in KiB:
+//
+static size_t
+resident_size () {
+    std::ifstream statm ("/proc/self/statm");
+
+    size_t total, resident;
+
+    if (statm >> total >> resident)
+        return resident * (sysconf (_SC_PAGESIZE) / 1024);
+
+    struct rusage usage;
+    getrusage (RUSAGE_SELF, &usage);
+
+#if defined (__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif // __APPLE__
+}
+
+struct record_t {
+    std::string clip, model, cpu;
+    size_t threads, width, height, frames;
+
+    double fps, p50, p99, prepare, update;
+    size_t rss;
+
+    //
+    // Blocks allocated per frame, and blocks the arena had to take from the
+    // system, after the warmup:
+    //
+    double allocations;
+    size_t misses;
+
+    //
+    // The mean intersection over union of the masks with the ground truth,
+    // after the warmup (NaN without ground truth):
+    //
+    double iou;
+};
+
+static double
+percentile (std::vector< double > xs, double p) {
+    if (xs.empty ())
+        return 0;
+
+    std::sort (xs.begin (), xs.end ());
+
+    const size_t i = std::ceil (p * xs.size ());
+    return xs [(std::min) (xs.size (), (std::max) (i, size_t (1))) - 1];
+}
+
+static double
+mean (const std::vector< double >& xs) {
+    double sum = 0;
+
+    for (auto x : xs)
+        sum += x;
+
+    return xs.empty () ? 0 : sum / xs.size ();
+}
+
+static double
+milliseconds (clock_type::duration arg) {
+    return std::chrono::duration< double, std::milli > (arg).count ();
+}
+
+static double
+iou (const cv::Mat& lhs, const cv::Mat& rhs) {
+    const int u = cv::countNonZero (lhs | rhs);
+    return u ? double (cv::countNonZero (lhs & rhs)) / u : 1.;
+}
+
+static record_t
+run (const clip_t& clip, const std::vector< cv::Mat >& frames,
+     const std::vector< cv::Mat >& truth,
+     const bench_model_t& model, size_t threads, size_t warmup) {
+#if defined (_OPENMP)
+    omp_set_num_threads (threads);
+#endif // _OPENMP
+
+    //
+    // The arena outlives the model, and counts what a frame allocates:
+    //
+    bs::arena_t arena;
+    bs::arena_scope_t scope (arena);
+
+    auto op = model.make (model.prepare (frames.front ()));
+
+    std::vector< double > prepare, update, latency, ious;
+    bs::arena_t::counters_t counters { };
+
+    clock_type::duration total { };
+
+    for (size_t i = 1; i < frames.size (); ++i) {
+        if (i == warmup + 1)
+            counters = arena.counters ();
+
+        const auto t0 = clock_type::now ();
+        const auto src = model.prepare (frames [i]);
+
+        const auto t1 = clock_type::now ();
+        const auto& mask = op (src);
+
+        const auto t2 = clock_type::now ();
+
+        if (i > warmup) {
+            prepare.push_back (milliseconds (t1 - t0));
+            update.push_back (milliseconds (t2 - t1));
+            latency.push_back (milliseconds (t2 - t0));
+
+            total += t2 - t0;
+
+            if (!truth.empty ())
+                ious.push_back (iou (mask, truth [i]));
+        }
+    }
+
+    counters = arena.counters () - counters;
+
+    const auto& frame = frames.front ();
+    const double seconds = milliseconds (total) / 1000;
+
+    return record_t {
+        clip.name, model.name, bs::cpu_tier_name (bs::cpu_tier ()),
+        threads, size_t (frame.cols), size_t (frame.rows), latency.size (),
+        seconds > 0 ? latency.size () / seconds : 0,
+        percentile (latency, .5), percentile (latency, .99),
+        mean (prepare), mean (update),
+        resident_size (),
+        latency.empty () ? 0. : double (counters.allocations) / latency.size (),
+        latency.empty () ? 0 : counters.misses + counters.header_misses,
+        ious.empty () ? std::nan ("") : mean (ious) };
+}
+
+////////////////////////////////////////////////////////////////////////
+
+static void
+write_csv (std::ostream& out, const std::vector< record_t >& records) {
+    out << "clip,model,cpu,threads,width,height,frames,fps,p50_ms,p99_ms,"
+        "prepare_ms,update_ms,rss_kb,allocations,misses,iou\n";
+
+    for (const auto& r : records) {
+        out << r.clip << ',' << r.model << ',' << r.cpu << ','
+            << r.threads << ',' << r.width << ',' << r.height << ','
+            << r.frames << ','
+            << r.fps << ',' << r.p50 << ',' << r.p99 << ','
+            << r.prepare << ',' << r.update << ',' << r.rss << ','
+            << r.allocations << ',' << r.misses << ',';
+
+        if (!std::isnan (r.iou))
+            out << r.iou;
+
+        out << '\n';
+    }
+}
+
+static void
+write_json (std::ostream& out, const std::vector< record_t >& records) {
+    auto quoted = [](const std::string& s) {
+        std::ostringstream ss;
+        ss << std::quoted (s);
+        return ss.str ();
+    };
+
+    out << "[\n";
+
+    for (size_t i = 0; i < records.size (); ++i) {
+        const auto& r = records [i];
+
+        out << "  { \"clip\": " << quoted (r.clip)
+            << ", \"model\": " << quoted (r.model)
+            << ", \"cpu\": " << quoted (r.cpu)
+            << ", \"threads\": " << r.threads
+            << ", \"width\": " << r.width
+            << ", \"height\": " << r.height
+            << ", \"frames\": " << r.frames
+            << ", \"fps\": " << r.fps
+            << ", \"p50_ms\": " << r.p50
+            << ", \"p99_ms\": " << r.p99
+            << ", \"stages\": { \"prepare_ms\": " << r.prepare
+            << ", \"update_ms\": " << r.update << " }"
+            << ", \"rss_kb\": " << r.rss
+            << ", \"allocations\": " << r.allocations
+            << ", \"misses\": " << r.misses
+            << ", \"iou\": ";
+
+        if (std::isnan (r.iou))
+            out << "null";
+        else
+            out << r.iou;
+
+        out << " }"
+            << (i + 1 < records.size () ? "," : "") << "\n";
+    }
+
+    out << "]\n";
+}
+
+////////////////////////////////////////////////////////////////////////
+
+static void
+process_bench (const options_t& opts) {
+    std::vector< bench_model_t > models;
+
+    if (opts.have ("model")) {
+        for (const auto& name : opts ["model"].as< std::vector< std::string > > ()) {
+            const auto& all = bench_models ();
+
+            auto iter = std::find_if (all.begin (), all.end (), [&](auto& m) {
+                    return m.name == name; });
+
+            if (iter == all.end ())
+                throw std::invalid_argument ("unknown model: " + name);
+
+            models.push_back (*iter);
+        }
+    }
+    else
+        models = bench_models ();
+
+    const size_t n = opts ["frames"].as< size_t > ();
+
+    const auto clips = opts.have ("scene")
+        ? std::vector< clip_t > { make_scene (opts ["scene"].as< std::string > (), n) }
+        : load_clips (opts ["input"].as< std::string > (), n);
+
+    const size_t warmup = opts ["warmup"].as< size_t > ();
+
+    std::vector< record_t > records;
+
+    for (const auto& clip : clips) {
+        if (clip.frames.size () < 2)
+            continue;
+
+        for (auto width : opts ["width"].as< std::vector< size_t > > ()) {
+            std::vector< cv::Mat > frames, truth;
+
+            for (const auto& frame : clip.frames) {
+                if (0 == width || int (width) == frame.cols)
+                    frames.push_back (frame);
+                else {
+                    cv::Mat tmp;
+                    cv::resize (frame, tmp, cv::Size (), double (width) / frame.cols,
+                                double (width) / frame.cols, cv::INTER_AREA);
+                    frames.push_back (tmp);
+                }
+            }
+
+            for (const auto& mask : clip.truth) {
+                if (0 == width || int (width) == mask.cols)
+                    truth.push_back (mask);
+                else {
+                    cv::Mat tmp;
+                    cv::resize (mask, tmp, frames.front ().size (), 0, 0,
+                                cv::INTER_NEAREST);
+                    truth.push_back (tmp);
+                }
+            }
+
+            for (const auto& model : models)
+                for (auto threads : opts ["threads"].as< std::vector< size_t > > ())
+                    records.push_back (
+                        run (clip, frames, truth, model, threads, warmup));
+        }
+    }
+
+    std::ofstream file;
+
+    if (opts.have ("output"))
+        file.open (opts ["output"].as< std::string > ());
+
+    std::ostream& out = opts.have ("output") ? file : std::cout;
+
+    if (opts ["format"].as< std::string > () == "json")
+        write_json (out, records);
+    else
+        write_csv (out, records);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+int main (int argc, char** argv) {
+    program_options_from (argc, argv);
+    return process_bench (global_options ()), 0;
+}
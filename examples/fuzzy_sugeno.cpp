@@ -1,6 +1,6 @@
 #include <iostream>
+#include <vector>
 
-#include <bs/ewma.hpp>
 #include <bs/frame_range.hpp>
 #include <bs/fuzzy_sugeno.hpp>
 #include <bs/utils.hpp>
@@ -70,6 +70,7 @@ options_t::options_t (int argc, char** argv) {
 
     desc_->add (generic);
     desc_->add (config);
+    desc_->add (loop_options ());
 
     store (po::command_line_parser (argc, argv).options (*desc_).run (), map_);
 
@@ -102,48 +103,48 @@ program_options_from (int& argc, char** argv) {
 
 ////////////////////////////////////////////////////////////////////////
 
-static cv::Mat
-bootstrap (cv::VideoCapture& cap) {
+//
+// The first n frames, as a batch to bootstrap the model from:
+//
+static std::vector< cv::Mat >
+bootstrap (cv::VideoCapture& cap, size_t n) {
     using namespace ranges;
 
-    //
-    // The bootstrapping function:
-    //
-    bs::ewma_t f;
+    std::vector< cv::Mat > frames;
 
-    //
-    // Learn the background over 15 frames:
-    //
-    auto frames = bs::getframes_from (cap);
-
-    for (auto frame : (frames | view::take (15))) {
-        f (bs::float_from (frame));
-    }
+    for (auto frame : (bs::getframes_from (cap) | view::take (n)))
+        frames.push_back (frame.clone ());
 
-    return f.value ();
+    return frames;
 }
 
 static void
 process_fuzzy_sugeno (cv::VideoCapture& cap, const options_t& opts) {
     const bool display = opts.have ("display");
 
-    auto background_model = bootstrap (cap);
+    const auto frames = bootstrap (
+        cap, opts ["learning-frames"].as< size_t > ());
+
+    if (frames.empty ())
+        return;
 
     bs::fuzzy_sugeno_t fuzzy_sugeno (
-        background_model,
+        frames.front (),
         opts ["alpha"].as< double > (),
         opts ["threshold"].as< double > (),
         opts ["measure"].as< std::vector< double > > ());
 
-    for (auto& frame : bs::getframes_from (cap)) {
-        bs::frame_delay temp { 10 };
+    fuzzy_sugeno.bootstrap (frames);
 
-        const auto mask = fuzzy_sugeno (frame);
+    frame_loop_t loop (opts);
+
+    for (auto& frame : bs::getframes_from (cap)) {
+        const auto& mask = fuzzy_sugeno (frame);
 
         if (display)
             imshow ("Fuzzy Sugeno filter", mask);
 
-        if (temp.wait_for_key (27))
+        if (loop (mask))
             break;
     }
 }
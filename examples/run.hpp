@@ -3,13 +3,145 @@
 #ifndef BS_EXAMPLES_RUN_HPP
 #define BS_EXAMPLES_RUN_HPP
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <string>
+#include <thread>
 
 #include <boost/filesystem.hpp>
 namespace fs = boost::filesystem;
 
+#include <boost/program_options.hpp>
+
+#include <opencv2/highgui.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/videoio.hpp>
+
 #include <options.hpp>
 
+inline bool
+is_video_file (const fs::path& filename) {
+    const fs::path ext = filename.extension ();
+    return ext == ".avi" || ext == ".mp4" || ext == ".mpg" || ext == ".mov";
+}
+
+//
+// The options of the frame loop, common to the examples:
+//
+inline boost::program_options::options_description
+loop_options () {
+    namespace po = boost::program_options;
+
+    po::options_description loop ("Loop options");
+
+    loop.add_options ()
+    ("fps", po::value< double > ()->default_value (0.),
+     "pace the loop at this frame rate, 0 runs as fast as possible (0).")
+
+    ("output,o", po::value< std::string > (),
+     "write the masks to a video file, or as numbered images to a directory.");
+
+    return loop;
+}
+
+//
+// The frame loop control of the examples. Without display the frames are
+// processed back to back, without a call to waitKey; --fps paces the loop,
+// with or without display, and --output sinks the masks:
+//
+//     frame_loop_t loop (opts);
+//
+//     for (auto& frame : bs::getframes_from (cap))
+//         if (loop (model (frame)))
+//             break;
+//
+struct frame_loop_t {
+    using clock_type = std::chrono::steady_clock;
+
+public:
+    explicit frame_loop_t (const options_t& opts)
+        : display_ (opts.have ("display")), fps_ (opts ["fps"].as< double > ()),
+          period_ (), deadline_ (clock_type::now ()), index_ () {
+        if (fps_ > 0)
+            period_ = std::chrono::duration_cast< clock_type::duration > (
+                std::chrono::duration< double > (1 / fps_));
+
+        if (opts.have ("output"))
+            output_ = opts ["output"].as< std::string > ();
+    }
+
+public:
+    //
+    // Sinks the mask and waits for the next frame, if paced; returns true when
+    // the loop should stop (Esc):
+    //
+    bool
+    operator() (const cv::Mat& mask) {
+        using namespace std::chrono;
+
+        if (!output_.empty ())
+            sink (mask);
+
+        if (period_.count ()) {
+            //
+            // Late frames push the schedule back rather than catch up:
+            //
+            deadline_ = (std::max) (deadline_ + period_, clock_type::now ());
+
+            if (!display_)
+                std::this_thread::sleep_until (deadline_);
+        }
+
+        if (!display_)
+            return false;
+
+        const int remaining = duration_cast< milliseconds > (
+            deadline_ - clock_type::now ()).count ();
+
+        return 27 == cv::waitKey ((std::max) (remaining, 1));
+    }
+
+private:
+    void
+    sink (const cv::Mat& mask) {
+        const fs::path path (output_);
+
+        if (is_video_file (path)) {
+            if (!writer_.isOpened ())
+                writer_.open (
+                    output_, cv::VideoWriter::fourcc ('M', 'J', 'P', 'G'),
+                    fps_ > 0 ? fps_ : 25, mask.size (), 3 == mask.channels ());
+
+            writer_ << mask;
+        }
+        else {
+            if (0 == index_)
+                fs::create_directories (path);
+
+            char name [32];
+            snprintf (name, sizeof name, "%06zu.png", index_);
+
+            cv::imwrite ((path / name).string (), mask);
+        }
+
+        ++index_;
+    }
+
+private:
+    bool display_;
+
+    double fps_;
+    clock_type::duration period_;
+    clock_type::time_point deadline_;
+
+    std::string output_;
+    cv::VideoWriter writer_;
+
+    size_t index_;
+};
+
 template< typename Function >
 void
 run_from_stream (Function f, cv::VideoCapture& cap, const options_t& opts) {
@@ -20,15 +152,15 @@ template< typename Function >
 void
 run_from_file_with (Function f, const options_t& opts) {
     const fs::path& filename (opts ["input"].as< std::string > ());
-    const fs::path ext = filename.extension ();
 
-    if (ext == ".avi" || ext == ".mp4" || ext == ".mpg" || ext == ".mov") {
+    //
+    // Files are read as fast as the model goes, the pacing is the loop's:
+    //
+    if (is_video_file (filename)) {
         cv::VideoCapture cap;
 
-        if (cap.open (filename.generic_string ())) {
-            cap.set (cv::CAP_PROP_FPS, 25);
+        if (cap.open (filename.generic_string ()))
             run_from_stream (f, cap, opts);
-        }
     }
     else
         std::cerr << "unsupported file type" << std::endl;
@@ -42,7 +174,9 @@ run_from_camera_with (Function f, const options_t& opts) {
     const int stream = std::stoi (opts ["input"].as< std::string > ());
 
     if (cap.open (stream)) {
-        cap.set (cv::CAP_PROP_FPS, 25);
+        const double fps = opts ["fps"].as< double > ();
+
+        cap.set (cv::CAP_PROP_FPS, fps > 0 ? fps : 25);
         run_from_stream (f, cap, opts);
     }
 }
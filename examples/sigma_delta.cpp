@@ -47,6 +47,7 @@ options_t::options_t (int argc, char** argv) {
 
     desc_->add (generic);
     desc_->add (config);
+    desc_->add (loop_options ());
 
     store (po::command_line_parser (argc, argv).options (*desc_).run (), map_);
 
@@ -94,15 +95,15 @@ process_sigma_delta (cv::VideoCapture& cap, const options_t& opts) {
         opts ["min-variance"].as< size_t > (),
         opts ["max-variance"].as< size_t > ());
 
-    for (auto& frame : bs::getframes_from (cap)) {
-        bs::frame_delay temp { 10 };
+    frame_loop_t loop (opts);
 
-        auto mask = sigma_delta (bs::scale_frame (frame));
+    for (auto& frame : bs::getframes_from (cap)) {
+        const auto& mask = sigma_delta (bs::scale_frame (frame));
 
         if (display)
             imshow ("Sigma-delta difference", mask);
 
-        if (temp.wait_for_key (27))
+        if (loop (mask))
             break;
     }
 }
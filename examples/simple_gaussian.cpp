@@ -1,6 +1,6 @@
 #include <iostream>
+#include <vector>
 
-#include <bs/ewma.hpp>
 #include <bs/frame_range.hpp>
 #include <bs/simple_gaussian.hpp>
 #include <bs/utils.hpp>
@@ -49,6 +49,7 @@ options_t::options_t (int argc, char** argv) {
 
     desc_->add (generic);
     desc_->add (config);
+    desc_->add (loop_options ());
 
     store (po::command_line_parser (argc, argv).options (*desc_).run (), map_);
 
@@ -81,47 +82,46 @@ program_options_from (int& argc, char** argv) {
 
 ////////////////////////////////////////////////////////////////////////
 
-static cv::Mat
-bootstrap (cv::VideoCapture& cap) {
+//
+// The first n frames, as a batch to bootstrap the model from:
+//
+static std::vector< cv::Mat >
+bootstrap (cv::VideoCapture& cap, size_t n) {
     using namespace ranges;
 
-    //
-    // The bootstrapping function:
-    //
-    bs::ewma_t f;
+    std::vector< cv::Mat > frames;
 
-    //
-    // Learn the background over 30 frames:
-    //
-    auto frames = bs::getframes_from (cap);
-
-    for (auto frame : (frames | view::take (30))) {
-        f (frame);
-    }
+    for (auto frame : (bs::getframes_from (cap) | view::take (n)))
+        frames.push_back (frame.clone ());
 
-    return f.value ();
+    return frames;
 }
 
 static void
 process_simple_gaussian (cv::VideoCapture& cap, const options_t& opts) {
     const bool display = opts.have ("display");
 
-    auto background_model = bootstrap (cap);
+    const auto frames = bootstrap (cap, 30);
+
+    if (frames.empty ())
+        return;
 
     bs::simple_gaussian_t simple_gaussian (
-        background_model,
+        frames.front (),
         opts ["alpha"].as< double > (),
         opts ["threshold"].as< double > ());
 
-    for (auto& frame : bs::getframes_from (cap)) {
-        bs::frame_delay temp { 0 };
+    simple_gaussian.bootstrap (frames);
 
-        auto mask = simple_gaussian (frame);
+    frame_loop_t loop (opts);
+
+    for (auto& frame : bs::getframes_from (cap)) {
+        const auto& mask = simple_gaussian (frame);
 
         if (display)
             imshow ("Simple Gaussian filter", mask);
 
-        if (temp.wait_for_key (27))
+        if (loop (mask))
             break;
     }
 }
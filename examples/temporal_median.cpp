@@ -1,6 +1,6 @@
 #include <iostream>
+#include <vector>
 
-#include <bs/ewma.hpp>
 #include <bs/frame_range.hpp>
 #include <bs/utils.hpp>
 #include <bs/temporal_median.hpp>
@@ -52,12 +52,15 @@ options_t::options_t (int argc, char** argv) {
      "distance from median for low threshold(2)")
 
     ("hi", po::value< size_t > ()->default_value (4),
-     "distance from median for high threshold (4)");
+     "distance from median for high threshold (4)")
+
+    ("hysteresis", "keep whole low threshold regions with a high pixel.");
 
     desc_ = boost::make_shared< po::options_description > ();
 
     desc_->add (generic);
     desc_->add (config);
+    desc_->add (loop_options ());
 
     store (po::command_line_parser (argc, argv).options (*desc_).run (), map_);
 
@@ -90,49 +93,49 @@ program_options_from (int& argc, char** argv) {
 
 ////////////////////////////////////////////////////////////////////////
 
-static cv::Mat
-bootstrap (cv::VideoCapture& cap) {
+//
+// The first n frames, as a batch to bootstrap the model from:
+//
+static std::vector< cv::Mat >
+bootstrap (cv::VideoCapture& cap, size_t n) {
     using namespace ranges;
 
-    //
-    // The bootstrapping function:
-    //
-    bs::ewma_t f;
+    std::vector< cv::Mat > frames;
 
-    //
-    // Learn the background over 15 frames:
-    //
-    auto frames = bs::getframes_from (cap);
-
-    for (auto frame : (frames | view::take (15))) {
-        f (bs::scale_frame (frame));
-    }
+    for (auto frame : (bs::getframes_from (cap) | view::take (n)))
+        frames.push_back (bs::scale_frame (frame));
 
-    return f.value ();
+    return frames;
 }
 
 static void
 process_temporal_median_background (cv::VideoCapture& cap, const options_t& opts) {
     const bool display = opts.have ("display");
 
-    auto background_model = bootstrap (cap);
+    const auto frames = bootstrap (cap, 15);
+
+    if (frames.empty ())
+        return;
 
     bs::temporal_median_t temporal_median (
-        background_model,
+        frames.front (),
         opts ["history-size" ].as< size_t > (),
         opts ["frame-interval" ].as< size_t > (),
         opts ["lo" ].as< size_t > (),
-        opts ["hi" ].as< size_t > ());
+        opts ["hi" ].as< size_t > (),
+        opts.have ("hysteresis"));
 
-    for (auto& frame : bs::getframes_from (cap)) {
-        bs::frame_delay temp { 10 };
+    temporal_median.bootstrap (frames);
 
-        auto mask = temporal_median (bs::scale_frame (frame));
+    frame_loop_t loop (opts);
+
+    for (auto& frame : bs::getframes_from (cap)) {
+        const auto& mask = temporal_median (bs::scale_frame (frame));
 
         if (display)
             imshow ("Temporal median", mask);
 
-        if (temp.wait_for_key (27))
+        if (loop (mask))
             break;
     }
 }
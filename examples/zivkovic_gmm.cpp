@@ -1,6 +1,6 @@
 #include <iostream>
+#include <vector>
 
-#include <bs/ewma.hpp>
 #include <bs/frame_range.hpp>
 #include <bs/zivkovic_gmm.hpp>
 #include <bs/utils.hpp>
@@ -42,6 +42,9 @@ options_t::options_t (int argc, char** argv) {
     ("input,i", po::value< std::string > ()->default_value ("0"),
      "input (file or stream index).")
 
+    ("bootstrap", po::value< size_t > ()->default_value (0),
+     "start the mixtures from a batch of the first frames (0).")
+
     ("size,s", po::value< size_t > ()->default_value (4UL),
      "maximum number of distributions.")
 
@@ -64,6 +67,7 @@ options_t::options_t (int argc, char** argv) {
 
     desc_->add (generic);
     desc_->add (config);
+    desc_->add (loop_options ());
 
     store (po::command_line_parser (argc, argv).options (*desc_).run (), map_);
 
@@ -108,23 +112,41 @@ process_zivkovic_gmm (cv::VideoCapture& cap, const options_t& opts) {
         opts ["weight-threshold"].as< double > (),
         opts ["bias"].as< double > ());
 
-    namedWindow ("Zivkovic GMM");
-    namedWindow ("Zivkovic GMM background");
+    if (display) {
+        namedWindow ("Zivkovic GMM");
+        namedWindow ("Zivkovic GMM background");
 
-    moveWindow ("Zivkovic GMM", 0, 0);
-    moveWindow ("Zivkovic GMM background", 512, 0);
+        moveWindow ("Zivkovic GMM", 0, 0);
+        moveWindow ("Zivkovic GMM background", 512, 0);
+    }
 
-    for (auto& frame : bs::getframes_from (cap)) {
-        bs::frame_delay temp { 0 };
+    if (const size_t n = opts ["bootstrap"].as< size_t > ()) {
+        std::vector< cv::Mat > frames;
+
+        for (auto& frame : bs::getframes_from (cap)) {
+            frames.push_back (bs::resize_frame (frame, 512. / frame.cols));
+
+            if (frames.size () == n)
+                break;
+        }
 
+        if (!frames.empty ())
+            zivkovic_gmm.bootstrap (frames);
+    }
+
+    frame_loop_t loop (opts);
+
+    for (auto& frame : bs::getframes_from (cap)) {
         auto src = bs::resize_frame (frame, 512. / frame.cols);
 
+        const auto& mask = zivkovic_gmm (src);
+
         if (display) {
-            imshow ("Zivkovic GMM", zivkovic_gmm (src));
+            imshow ("Zivkovic GMM", mask);
             imshow ("Zivkovic GMM background", zivkovic_gmm.background ());
         }
 
-        if (temp.wait_for_key (27))
+        if (loop (mask))
             break;
     }
 }
@@ -4,6 +4,8 @@
 #include <bs/defs.hpp>
 #include <bs/detail/base.hpp>
 
+#include <vector>
+
 #include <opencv2/core/mat.hpp>
 
 namespace bs {
@@ -25,14 +27,26 @@ namespace bs {
 //
 
 struct adaptive_median_t : detail::base_t {
-    adaptive_median_t (const cv::Mat&, size_t, size_t);
+    adaptive_median_t (
+        const cv::Mat&, size_t, size_t, const execution_t& = { });
 
 public:
     const cv::Mat&
     operator() (const cv::Mat&);
 
+    //
+    // Starts from the median of a batch of frames:
+    //
+    void
+    bootstrap (const std::vector< cv::Mat >&);
+
 private:
     size_t frame_interval_, frame_counter_, threshold_;
+
+    //
+    // Scratch planes, kept across frames:
+    //
+    cv::Mat a_, b_;
 };
 
 }
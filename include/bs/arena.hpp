@@ -0,0 +1,145 @@
+#ifndef BS_ARENA_HPP
+#define BS_ARENA_HPP
+
+#include <bs/defs.hpp>
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+namespace bs {
+
+//
+// A cv::MatAllocator serving the matrices from slabs of 2MB pages (huge pages
+// where the kernel has them, Linux). The blocks go by power-of-two size
+// classes; a released block returns to the free list of its class, so the
+// temporaries of one frame are the storage of the next, and a steady stream
+// of frames of one size stops asking the system for memory after the first
+// frames. Blocks larger than a slab are mapped on their own and recycled by
+// size alike. The matrix headers (cv::UMatData) are recycled too.
+//
+// The arena must outlive the matrices it allocated; the memory goes back to
+// the system on destruction only (see trim for the large blocks):
+//
+//     bs::arena_t arena;
+//     bs::arena_scope_t scope (arena);
+//
+//     for (...) {
+//         const auto before = arena.counters ();
+//         model (frame);
+//
+//         const auto delta = arena.counters () - before;
+//         BS_ASSERT (0 == delta.misses && 0 == delta.header_misses);
+//     }
+//
+struct arena_t : cv::MatAllocator {
+    static constexpr size_t slab_size = 2UL << 20;
+
+    struct counters_t {
+        //
+        // Buffers handed out and given back, and those that had to be carved
+        // or mapped anew; the same for the matrix headers, which come from the
+        // arena as well, user data or not; and the memory mapped from the
+        // system, in bytes:
+        //
+        size_t allocations, deallocations, misses;
+        size_t headers, header_misses;
+        size_t mapped;
+
+        counters_t
+        operator- (const counters_t& other) const {
+            return {
+                allocations - other.allocations,
+                deallocations - other.deallocations,
+                misses - other.misses,
+                headers - other.headers,
+                header_misses - other.header_misses,
+                mapped - other.mapped };
+        }
+    };
+
+public:
+    arena_t ();
+    ~arena_t ();
+
+    arena_t (const arena_t&) = delete;
+    arena_t& operator= (const arena_t&) = delete;
+
+public:
+    cv::UMatData*
+    allocate (int, const int*, int, void*, size_t*,
+              cv::AccessFlag, cv::UMatUsageFlags) const override;
+
+    bool
+    allocate (cv::UMatData*, cv::AccessFlag, cv::UMatUsageFlags) const override;
+
+    void
+    deallocate (cv::UMatData*) const override;
+
+public:
+    counters_t
+    counters () const;
+
+    //
+    // Returns the free large blocks to the system:
+    //
+    void
+    trim ();
+
+private:
+    void*
+    get (size_t, size_t&) const;
+
+    void
+    put (void*, size_t) const;
+
+    void*
+    carve (size_t) const;
+
+private:
+    struct block_t {
+        block_t* next;
+        size_t size;
+    };
+
+    static constexpr size_t min_class = 6, max_class = 21;
+
+    mutable std::mutex mutex_;
+
+    //
+    // Free lists by size class, of blocks of 1 << (min_class + i) bytes, and
+    // of blocks larger than a slab:
+    //
+    mutable block_t* free_ [max_class - min_class + 1] = { };
+    mutable block_t* large_ = nullptr;
+
+    //
+    // The slabs and the large mappings, and the unused tail of the last slab:
+    //
+    mutable std::vector< std::pair< void*, size_t > > mappings_;
+    mutable char *first_ = nullptr, *last_ = nullptr;
+
+    mutable counters_t counters_ = { };
+};
+
+//
+// Makes an arena the default allocator of the matrices while the scope lives,
+// restoring the previous one on exit. The default allocator is global; the
+// scope is for the thread that drives the models, not for one model:
+//
+struct arena_scope_t {
+    explicit arena_scope_t (arena_t&);
+    ~arena_scope_t ();
+
+    arena_scope_t (const arena_scope_t&) = delete;
+    arena_scope_t& operator= (const arena_scope_t&) = delete;
+
+private:
+    cv::MatAllocator* previous_;
+};
+
+}
+
+#endif // BS_ARENA_HPP
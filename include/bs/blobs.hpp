@@ -0,0 +1,98 @@
+#ifndef BS_BLOBS_HPP
+#define BS_BLOBS_HPP
+
+#include <bs/defs.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+namespace bs {
+
+struct blob_t {
+    cv::Rect bbox;
+    size_t area;
+    cv::Point2d centroid;
+};
+
+//
+// Connected components of a binary mask, e.g., the mask of any of the models,
+// and their statistics. The mask is run-length encoded row by row and the runs
+// are joined in the same pass with a union-find over the run indices. With
+// more than one tile, horizontal bands of the mask are labeled in parallel and
+// merged at the seams. Blobs with an area outside of [min, max] are dropped:
+//
+struct blobs_t {
+    explicit blobs_t (
+        size_t min_area = 1,
+        size_t max_area = (std::numeric_limits< size_t >::max) (),
+        int connectivity = 8, size_t tiles = 1);
+
+public:
+    const std::vector< blob_t >&
+    operator() (const cv::Mat&);
+
+    const std::vector< blob_t >&
+    blobs () const {
+        return blobs_;
+    }
+
+public:
+    struct run_t {
+        int row, begin, end;
+    };
+
+    //
+    // The runs of the last mask, in scan order, and the component of each,
+    // numbered in the order of their first runs, area-filtered or not:
+    //
+    const std::vector< run_t >&
+    runs () const {
+        return runs_;
+    }
+
+    const std::vector< uint32_t >&
+    labels () const {
+        return labels_;
+    }
+
+    size_t
+    components () const {
+        return components_;
+    }
+
+    //
+    // The number of bands labeled in parallel:
+    //
+    void
+    tiles (size_t arg) {
+        tiles_ = arg ? arg : 1;
+    }
+
+private:
+    void label (const cv::Mat&, size_t, int, int);
+    void merge (size_t, size_t, size_t, size_t);
+
+    uint32_t find (uint32_t);
+    void unite (uint32_t, uint32_t);
+
+private:
+    size_t min_area_, max_area_;
+    int offset_;
+    size_t tiles_;
+
+    std::vector< std::vector< run_t > > band_runs_;
+    std::vector< std::vector< uint32_t > > band_parents_;
+
+    std::vector< run_t > runs_;
+    std::vector< uint32_t > parents_, labels_;
+    size_t components_ { };
+
+    std::vector< blob_t > blobs_;
+};
+
+}
+
+#endif // BS_BLOBS_HPP
@@ -0,0 +1,96 @@
+#ifndef BS_COMPACT_MASK_HPP
+#define BS_COMPACT_MASK_HPP
+
+#include <bs/defs.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+namespace bs {
+
+//
+// A binary mask, one bit per pixel. Bit j of word k in a row is the pixel in
+// column 64 k + j; the bits past the last column are zero:
+//
+struct packed_mask_t {
+    int rows { }, cols { };
+    size_t stride { };
+
+    std::vector< uint64_t > bits;
+
+    uint64_t*
+    row (int i) {
+        return bits.data () + i * stride;
+    }
+
+    const uint64_t*
+    row (int i) const {
+        return bits.data () + i * stride;
+    }
+
+    void
+    create (int r, int c) {
+        rows = r;
+        cols = c;
+        stride = (size_t (c) + 63) / 64;
+        bits.resize (rows * stride);
+    }
+};
+
+//
+// A binary mask as the list of its foreground spans, [begin, end), row by row;
+// the spans of row i are [offsets [i], offsets [i + 1]):
+//
+struct rle_mask_t {
+    struct span_t {
+        uint32_t begin, end;
+    };
+
+    int rows { }, cols { };
+
+    std::vector< uint32_t > offsets;
+    std::vector< span_t > spans;
+};
+
+//
+// Compact formats a model can be asked to emit, see detail::base_t:
+//
+constexpr unsigned MASK_PACKED = 1;
+constexpr unsigned MASK_RLE    = 2;
+
+//
+// Conversions, writing into the destination and reusing its storage. Any
+// non-zero pixel is foreground; decoded masks are 255/0 CV_8U:
+//
+void
+pack (const cv::Mat&, packed_mask_t&);
+
+void
+unpack (const packed_mask_t&, cv::Mat&);
+
+void
+encode (const cv::Mat&, rle_mask_t&);
+
+void
+encode (const packed_mask_t&, rle_mask_t&);
+
+void
+decode (const rle_mask_t&, cv::Mat&);
+
+inline cv::Mat
+unpack (const packed_mask_t& src) {
+    cv::Mat dst;
+    return unpack (src, dst), dst;
+}
+
+inline cv::Mat
+decode (const rle_mask_t& src) {
+    cv::Mat dst;
+    return decode (src, dst), dst;
+}
+
+}
+
+#endif // BS_COMPACT_MASK_HPP
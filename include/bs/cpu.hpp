@@ -0,0 +1,86 @@
+#ifndef BS_CPU_HPP
+#define BS_CPU_HPP
+
+#include <bs/defs.hpp>
+
+#include <utility>
+
+namespace bs {
+
+//
+// The instruction set tiers the kernels are compiled for (x86-64; elsewhere
+// there is only the baseline). The tier of the host is detected when the
+// library loads; the BS_CPU environment variable (sse2, sse4.1, avx2 or
+// avx512) caps it, e.g., to test the lower tiers on a newer host:
+//
+//     $ BS_CPU=sse4.1 bs_bench -i clips/
+//
+enum cpu_tier_t { CPU_SSE2, CPU_SSE41, CPU_AVX2, CPU_AVX512 };
+
+cpu_tier_t
+cpu_tier ();
+
+//
+// Caps the tier at run time, never above the one of the host:
+//
+void
+cpu_tier (cpu_tier_t);
+
+const char*
+cpu_tier_name (cpu_tier_t);
+
+}
+
+#if defined (__GNUC__) && defined (__x86_64__)
+#  define BS_INLINE inline __attribute__ ((always_inline))
+#  define BS_TARGET_SSE41  __attribute__ ((target ("sse4.1")))
+#  define BS_TARGET_AVX2   __attribute__ ((target ("avx2,fma")))
+#  define BS_TARGET_AVX512 __attribute__ ((target ("avx512f,avx512bw,avx2,fma")))
+#else
+#  define BS_INLINE inline
+#  define BS_TARGET_SSE41
+#  define BS_TARGET_AVX2
+#  define BS_TARGET_AVX512
+#endif // __GNUC__ && __x86_64__
+
+//
+// Compiles a kernel, a function declared BS_INLINE, once per tier, and defines
+// name_dispatch, which calls the clone for the current tier. The kernels work
+// on a row or a range of pixels, the callers keep the parallel loops:
+//
+//     template< typename T >
+//     BS_INLINE void
+//     foo_row (const T* src, T* dst, int n) { ... }
+//
+//     BS_CLONES (foo_row)
+//
+//     foo_row_dispatch (p, q, n);
+//
+#define BS_CLONE(name, tier, target)                                    \
+    template< typename... Args >                                        \
+    target inline auto                                                  \
+    name ## _ ## tier (Args&&... args) {                                \
+        return name (std::forward< Args > (args)...);                   \
+    }
+
+#define BS_CLONES(name)                                                 \
+    BS_CLONE (name, sse41, BS_TARGET_SSE41)                             \
+    BS_CLONE (name, avx2, BS_TARGET_AVX2)                               \
+    BS_CLONE (name, avx512, BS_TARGET_AVX512)                           \
+                                                                        \
+    template< typename... Args >                                        \
+    inline auto                                                         \
+    name ## _dispatch (Args&&... args) {                                \
+        switch (::bs::cpu_tier ()) {                                    \
+        case ::bs::CPU_AVX512:                                          \
+            return name ## _avx512 (std::forward< Args > (args)...);    \
+        case ::bs::CPU_AVX2:                                            \
+            return name ## _avx2 (std::forward< Args > (args)...);      \
+        case ::bs::CPU_SSE41:                                           \
+            return name ## _sse41 (std::forward< Args > (args)...);     \
+        default:                                                        \
+            return name (std::forward< Args > (args)...);               \
+        }                                                               \
+    }
+
+#endif // BS_CPU_HPP
@@ -2,29 +2,127 @@
 #define BS_DETAIL_BASE_HPP
 
 #include <bs/defs.hpp>
+#include <bs/compact_mask.hpp>
+#include <bs/execution.hpp>
+
 #include <opencv2/core/mat.hpp>
 
 namespace bs {
 namespace detail {
 
 struct base_t {
-    explicit base_t (const cv::Mat& background = { }, const cv::Mat& mask = { })
-        : background_ (background), mask_ (mask)
+    explicit base_t (const cv::Mat& background = { }, const cv::Mat& mask = { },
+                     const execution_t& execution = { })
+        : background_ (background), mask_ (mask),
+          execution_ (execution.resolved ())
     { }
 
+    virtual ~base_t () = default;
+
 public:
+    //
+    // The mask of the last update; the next update overwrites it in place,
+    // clone it to keep it:
+    //
     const cv::Mat&
     mask () const {
         return mask_;
     }
 
+    //
+    // The background of models that do not need it for detection is built
+    // from their state on the first request after an update:
+    //
     const cv::Mat&
     background () const {
+        if (stale_) {
+            const execution_scope_t scope (execution_);
+
+            materialize ();
+            stale_ = false;
+        }
+
         return background_;
     }
 
+    //
+    // Compact copies of the mask, kept up to date if requested with
+    // mask_format:
+    //
+    const packed_mask_t&
+    packed_mask () const {
+        return packed_;
+    }
+
+    const rle_mask_t&
+    rle_mask () const {
+        return rle_;
+    }
+
+    void
+    mask_format (unsigned arg) {
+        mask_format_ = arg;
+    }
+
+    //
+    // The threads and cores the parallel kernels of the model run on:
+    //
+    const execution_t&
+    execution () const {
+        return execution_;
+    }
+
+    void
+    execution (const execution_t& arg) {
+        execution_ = arg.resolved ();
+    }
+
 protected:
-    cv::Mat background_, mask_;
+    //
+    // Encodes the mask just computed by the model in the requested formats,
+    // while it is still in cache:
+    //
+    const cv::Mat&
+    emit_mask () {
+        if (mask_format_ & MASK_PACKED)
+            pack (mask_, packed_);
+
+        if (mask_format_ & MASK_RLE) {
+            if (mask_format_ & MASK_PACKED)
+                encode (packed_, rle_);
+            else
+                encode (mask_, rle_);
+        }
+
+        return mask_;
+    }
+
+protected:
+    //
+    // Called by the models that implement materialize, after each update:
+    //
+    void
+    invalidate_background () {
+        stale_ = true;
+    }
+
+private:
+    virtual void
+    materialize () const { }
+
+protected:
+    mutable cv::Mat background_;
+    cv::Mat mask_;
+
+    execution_t execution_;
+
+private:
+    mutable bool stale_ { };
+
+    packed_mask_t packed_;
+    rle_mask_t rle_;
+
+    unsigned mask_format_ { };
 };
 
 }}
@@ -0,0 +1,83 @@
+#ifndef BS_DETAIL_BOOTSTRAP_HPP
+#define BS_DETAIL_BOOTSTRAP_HPP
+
+#include <bs/defs.hpp>
+#include <bs/detail/pixel.hpp>
+#include <bs/utils.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+namespace bs {
+namespace detail {
+
+//
+// A mode of the samples of a pixel over a batch of frames: the mean, the sum
+// of the squared distances to it, and the number of samples:
+//
+template< typename T >
+struct batch_mode_t {
+    pixel_vec_t< T > m;
+    double q;
+    size_t n;
+
+    double
+    variance (double floor) const {
+        return (std::max) (floor, q / n);
+    }
+};
+
+//
+// Online k-means of the samples of pixel i over the frames: a sample joins
+// the nearest mode within the squared distance d, updating its mean and
+// spread incrementally (Welford), or starts a new one, replacing the mode
+// with the fewest samples when there are already k. The modes are returned by
+// decreasing number of samples:
+//
+template< typename T >
+inline void
+cluster_batch (const std::vector< cv::Mat >& frames, size_t i, size_t k,
+               double d, std::vector< batch_mode_t< T > >& modes) {
+    modes.clear ();
+
+    for (const auto& frame : frames) {
+        const auto x = vec_from (frame.at< T > (i));
+
+        auto iter = modes.end ();
+        double nearest = d;
+
+        for (auto p = modes.begin (); p != modes.end (); ++p) {
+            const auto delta = x - p->m;
+            const double distance = dot (delta);
+
+            if (distance < nearest) {
+                nearest = distance;
+                iter = p;
+            }
+        }
+
+        if (iter != modes.end ()) {
+            auto& mode = *iter;
+
+            const auto delta = x - mode.m;
+
+            ++mode.n;
+            mode.m += delta * (1. / mode.n);
+            mode.q += dot (delta, x - mode.m);
+        }
+        else if (modes.size () < k)
+            modes.push_back ({ x, 0., 1 });
+        else
+            *std::min_element (modes.begin (), modes.end (), [](auto& a, auto& b) {
+                    return a.n < b.n; }) = { x, 0., 1 };
+    }
+
+    std::sort (modes.begin (), modes.end (), [](auto& a, auto& b) {
+            return a.n > b.n; });
+}
+
+}}
+
+#endif // BS_DETAIL_BOOTSTRAP_HPP
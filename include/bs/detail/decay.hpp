@@ -0,0 +1,98 @@
+#ifndef BS_DETAIL_DECAY_HPP
+#define BS_DETAIL_DECAY_HPP
+
+#include <bs/defs.hpp>
+
+#include <cstddef>
+
+namespace bs {
+namespace detail {
+
+//
+// Lazy exponential decay of the mixture weights.
+//
+// On every frame the mixture models decay all the weights of a pixel by
+// (1 - α), add α to the weight of the matching (or the new) distribution and
+// re-normalize. Keeping the weights un-normalized, together with their sum Σ,
+// the same update reduces to adding α Σ / (1 - α) to the one matching weight;
+// the decay of all the others is implicit in the growth of Σ.
+//
+// The sums of all pixels grow at most at the same geometric rate, which is
+// tracked globally, as the scale of the current epoch. When the scale gets too
+// large a new epoch begins and the pixels, stamped with the epoch of their last
+// update, are brought into the new one lazily, the next time they are
+// evaluated. That is also where the deferred re-normalization happens: the
+// weights of a pixel are scaled to sum to 1, rather than by the growth of the
+// scale, since the sums of the pixels that lose weight to pruning or to a bias
+// fall behind the scale, epoch after epoch, down to zero otherwise.
+//
+
+struct decay_stamp_t {
+    double total;
+    size_t epoch;
+};
+
+struct lazy_decay_t {
+    explicit lazy_decay_t (double alpha, double limit = 1e64)
+        : alpha_ (alpha), ratio_ (alpha / (1. - alpha)), limit_ (limit),
+          scale_ (1.), epoch_ { }
+    {
+        BS_ASSERT (0 < alpha && alpha < 1);
+    }
+
+public:
+    //
+    // Advances the global scale by one frame:
+    //
+    void advance () {
+        scale_ /= 1. - alpha_;
+
+        if (scale_ > limit_) {
+            scale_ = 1.;
+            ++epoch_;
+        }
+    }
+
+    decay_stamp_t
+    stamp (double total = 1.) const {
+        return decay_stamp_t { total, epoch_ };
+    }
+
+    //
+    // Brings a pixel stamped in an older epoch into the current one; returns
+    // the factor the caller must apply to the pixel weights, which normalizes
+    // them. The sum is recomputed from the weights by the caller, which avoids
+    // the drift of the incremental updates:
+    //
+    double
+    rebase (decay_stamp_t& arg) const {
+        if (arg.epoch == epoch_)
+            return 1.;
+
+        const double factor = arg.total > 0 ? 1. / arg.total : 1.;
+
+        arg.total *= factor;
+        arg.epoch = epoch_;
+
+        return factor;
+    }
+
+    //
+    // The amount added to the matching weight, standing for the decay of all
+    // the weights of the pixel and the α added to the matching one:
+    //
+    double
+    increment (const decay_stamp_t& arg) const {
+        return ratio_ * arg.total;
+    }
+
+    double alpha () const { return alpha_; }
+
+private:
+    double alpha_, ratio_, limit_, scale_;
+    size_t epoch_;
+};
+
+}}
+
+#endif // BS_DETAIL_DECAY_HPP
@@ -5,6 +5,30 @@
 #include <opencv2/imgproc.hpp>
 
 namespace bs {
+namespace detail {
+
+//
+// The code of the pixel at the center of a 3x3 window, from its three rows;
+// the neighbors at or above the center plus the offset set the bits, clockwise
+// from the left one (bit 0) through the top-left one (bit 7):
+//
+template< typename T >
+inline unsigned
+lbp_code (const T* p, const T* q, const T* r, T off = { }) {
+    const T t = q [1] + off;
+
+    return
+        ((p [0] >= t) << 7) +
+        ((p [1] >= t) << 6) +
+        ((p [2] >= t) << 5) +
+        ((q [0] >= t)) +
+        ((q [2] >= t) << 4) +
+        ((r [0] >= t) << 1) +
+        ((r [1] >= t) << 2) +
+        ((r [2] >= t) << 3);
+}
+
+}
 
 cv::Mat
 lbp (const cv::Mat&);
@@ -0,0 +1,75 @@
+#ifndef BS_DETAIL_NUMA_HPP
+#define BS_DETAIL_NUMA_HPP
+
+#include <bs/defs.hpp>
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace bs {
+namespace detail {
+
+//
+// Page-aligned memory, not touched by the allocation: the pages land on the
+// node of the thread that first writes them, or, on Linux, preferably on the
+// given NUMA node (-1 for none):
+//
+void*
+numa_allocate (size_t, int = -1);
+
+void
+numa_deallocate (void*, size_t);
+
+//
+// The flat per-pixel state of a model. The elements are left unconstructed;
+// the model constructs them in a parallel loop with the schedule of its
+// update loop, so that each thread first-touches the pages it later updates:
+//
+template< typename T >
+struct numa_array_t {
+    static_assert (std::is_trivially_destructible< T >::value,
+                   "elements are never destroyed");
+
+    numa_array_t () = default;
+
+    numa_array_t (size_t n, int node)
+        : data_ (n ? static_cast< T* > (numa_allocate (n * sizeof (T), node)) : nullptr),
+          size_ (n)
+    { }
+
+    numa_array_t (numa_array_t&& other)
+        : data_ (std::exchange (other.data_, nullptr)),
+          size_ (std::exchange (other.size_, 0))
+    { }
+
+    numa_array_t&
+    operator= (numa_array_t&& other) {
+        std::swap (data_, other.data_);
+        std::swap (size_, other.size_);
+        return *this;
+    }
+
+    ~numa_array_t () {
+        if (data_)
+            numa_deallocate (data_, size_ * sizeof (T));
+    }
+
+public:
+    T* data () { return data_; }
+    const T* data () const { return data_; }
+
+    size_t size () const { return size_; }
+    bool empty () const { return 0 == size_; }
+
+    T& operator[] (size_t i) { return data_ [i]; }
+    const T& operator[] (size_t i) const { return data_ [i]; }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}}
+
+#endif // BS_DETAIL_NUMA_HPP
@@ -0,0 +1,83 @@
+#ifndef BS_DETAIL_PIXEL_HPP
+#define BS_DETAIL_PIXEL_HPP
+
+#include <bs/defs.hpp>
+
+#include <opencv2/core/mat.hpp>
+
+namespace bs {
+namespace detail {
+
+//
+// The input pixel types the models are specialized for: 8-bit gray, 8-bit BGR
+// and 16-bit gray:
+//
+template< typename T >
+struct pixel_traits;
+
+template< >
+struct pixel_traits< unsigned char > {
+    using value_type = unsigned char;
+
+    static constexpr int channels = 1;
+    static constexpr int type = CV_8UC1;
+    static constexpr double max = 255.;
+};
+
+template< >
+struct pixel_traits< unsigned short > {
+    using value_type = unsigned short;
+
+    static constexpr int channels = 1;
+    static constexpr int type = CV_16UC1;
+    static constexpr double max = 65535.;
+};
+
+template< >
+struct pixel_traits< cv::Vec3b > {
+    using value_type = unsigned char;
+
+    static constexpr int channels = 3;
+    static constexpr int type = CV_8UC3;
+    static constexpr double max = 255.;
+};
+
+//
+// The model-side representation of a pixel, one double per channel:
+//
+template< typename T, typename U = double >
+using pixel_vec_t = cv::Vec< U, pixel_traits< T >::channels >;
+
+template< typename U, typename T >
+inline pixel_vec_t< T, U >
+vec_from (const T& arg) {
+    if constexpr (1 == pixel_traits< T >::channels) {
+        return pixel_vec_t< T, U > (U (arg));
+    }
+    else {
+        return pixel_vec_t< T, U > (arg);
+    }
+}
+
+template< typename T >
+inline pixel_vec_t< T >
+vec_from (const T& arg) {
+    return vec_from< double > (arg);
+}
+
+template< typename T, typename U, int N >
+inline T
+pixel_from (const cv::Vec< U, N >& arg) {
+    static_assert (N == pixel_traits< T >::channels, "channel count mismatch");
+
+    if constexpr (1 == N) {
+        return cv::saturate_cast< T > (arg [0]);
+    }
+    else {
+        return T (arg);
+    }
+}
+
+}}
+
+#endif // BS_DETAIL_PIXEL_HPP
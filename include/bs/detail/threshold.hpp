@@ -2,6 +2,7 @@
 #define BS_DETAIL_THRESHOLD_HPP
 
 #include <bs/defs.hpp>
+#include <bs/cpu.hpp>
 
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
@@ -110,12 +111,26 @@ struct threshold_tozero_inv : threshold_base< T > {
     }
 };
 
+template< typename T, typename U >
+BS_INLINE void
+threshold_row (U* p, size_t n, const T& t) {
+    for (size_t j = 0; j < n; ++j)
+        p [j] = t (p [j]);
+}
+
+BS_CLONES (threshold_row)
+
+//
+// Thresholds into dst, which may be src; dst keeps its buffer if it already
+// has the size and type of src:
+//
 template< typename T >
-inline cv::Mat
-threshold (const cv::Mat& src, const T& t) {
+inline void
+threshold (const cv::Mat& src, cv::Mat& dst, const T& t) {
     using value_type = typename T::value_type;
 
-    cv::Mat dst = src.clone ();
+    if (dst.data != src.data)
+        src.copyTo (dst);
 
     size_t rows = dst.rows;
     size_t cols = dst.cols;
@@ -129,37 +144,41 @@ threshold (const cv::Mat& src, const T& t) {
         value_type* p = reinterpret_cast< value_type* > (
                             dst.ptr< unsigned char > (i));
 
-        for (size_t j = 0; j < cols; ++j)
-            p [j] = t (p [j]);
+        threshold_row_dispatch (p, cols, t);
     }
-
-    return dst;
 }
 
 template< typename T >
-inline cv::Mat
-threshold (const cv::Mat& src, T threshold_, T value, int type) {
+inline void
+threshold (const cv::Mat& src, cv::Mat& dst, T threshold_, T value, int type) {
     switch (type) {
     case cv::THRESH_BINARY:
-        return threshold (src, threshold_binary< T > (threshold_, value));
+        return threshold (src, dst, threshold_binary< T > (threshold_, value));
 
     case cv::THRESH_BINARY_INV:
-        return threshold (src, threshold_binary_inv< T > (threshold_, value));
+        return threshold (src, dst, threshold_binary_inv< T > (threshold_, value));
 
     case cv::THRESH_TRUNC:
-        return threshold (src, threshold_trunc< T > (threshold_, value));
+        return threshold (src, dst, threshold_trunc< T > (threshold_, value));
 
     case cv::THRESH_TOZERO:
-        return threshold (src, threshold_tozero< T > (threshold_, value));
+        return threshold (src, dst, threshold_tozero< T > (threshold_, value));
 
     case cv::THRESH_TOZERO_INV:
-        return threshold (src, threshold_tozero_inv< T > (threshold_, value));
+        return threshold (src, dst, threshold_tozero_inv< T > (threshold_, value));
 
     default:
         throw std::invalid_argument ("unsupported thresholding type");
     }
 }
 
+template< typename T >
+inline cv::Mat
+threshold (const cv::Mat& src, T threshold_, T value, int type) {
+    cv::Mat dst;
+    return threshold (src, dst, threshold_, value, type), dst;
+}
+
 }}
 
 #endif // BS_DETAIL_THRESHOLD_HPP
@@ -2,32 +2,184 @@
 #define BS_EWMA_HPP
 
 #include <bs/defs.hpp>
+
+#include <algorithm>
+#include <vector>
+
 #include <opencv2/core/mat.hpp>
 
 namespace bs {
+namespace detail {
 
-struct ewma_t {
-    explicit ewma_t (double alpha = .05) : alpha_ (alpha) { }
+//
+// The bootstrap accumulators fold 8-bit, 16-bit or float frames into a state
+// allocated on the first frame and updated in place afterwards; the
+// background is emitted in the type of the frames, or in the type given at
+// construction, on the first request after an update:
+//
+struct accumulator_t {
+    explicit accumulator_t (int type = -1) : type_ (type) { }
+
+    virtual ~accumulator_t () = default;
 
 public:
-    cv::Mat operator() (const cv::Mat& src) {
-        if (value_.empty ()) {
-            value_ = src;
-        }
-        else {
-            value_ = alpha_ * src + (1 - alpha_) * value_;
+    //
+    // The background is recomputed into the same buffer after an update, any
+    // header sharing it sees the new values; a caller keeping it across
+    // updates clones it:
+    //
+    const cv::Mat&
+    value () const {
+        if (stale_) {
+            materialize ();
+            stale_ = false;
         }
 
         return value_;
     }
 
-    const cv::Mat& value () const {
-        return value_;
+    //
+    // The number of frames accumulated:
+    //
+    size_t
+    size () const {
+        return size_;
+    }
+
+protected:
+    void
+    updated (const cv::Mat& src) {
+        if (0 == size_++)
+            target_ = type_ < 0 ? src.type () : CV_MAKETYPE (
+                CV_MAT_DEPTH (type_), src.channels ());
+
+        stale_ = true;
+    }
+
+private:
+    virtual void
+    materialize () const = 0;
+
+protected:
+    int type_, target_ { };
+    mutable cv::Mat value_;
+
+private:
+    size_t size_ { };
+    mutable bool stale_ { };
+};
+
+//
+// A ring of the last frames, copied into buffers allocated once:
+//
+struct window_t {
+    explicit window_t (size_t n) : frames_ (n), size_ (), next_ () {
+        BS_ASSERT (n);
+    }
+
+    //
+    // The frame the next push replaces, if the window is full:
+    //
+    const cv::Mat*
+    next () const {
+        return size_ == frames_.size () ? &frames_ [next_] : nullptr;
+    }
+
+    void
+    push (const cv::Mat& src) {
+        src.copyTo (frames_ [next_]);
+
+        next_ = (next_ + 1) % frames_.size ();
+        size_ = (std::min) (size_ + 1, frames_.size ());
+    }
+
+    size_t
+    size () const {
+        return size_;
+    }
+
+    const cv::Mat&
+    operator[] (size_t i) const {
+        return frames_ [i];
+    }
+
+private:
+    std::vector< cv::Mat > frames_;
+    size_t size_, next_;
+};
+
+}
+
+//
+// Exponentially weighted moving average, in a float state:
+//
+struct ewma_t : detail::accumulator_t {
+    explicit ewma_t (double alpha = .05, int type = -1)
+        : detail::accumulator_t (type), alpha_ (alpha)
+    { }
+
+public:
+    void
+    operator() (const cv::Mat&);
+
+    const cv::Mat&
+    state () const {
+        return state_;
     }
 
 private:
-    cv::Mat value_;
+    void
+    materialize () const override;
+
+private:
     double alpha_;
+    cv::Mat state_;
+};
+
+//
+// The mean of the last frames of the window, or of all frames if the window
+// is 0:
+//
+struct window_mean_t : detail::accumulator_t {
+    explicit window_mean_t (size_t window = 0, int type = -1)
+        : detail::accumulator_t (type), window_ (window ? window : 1),
+          windowed_ (window)
+    { }
+
+public:
+    void
+    operator() (const cv::Mat&);
+
+private:
+    void
+    materialize () const override;
+
+private:
+    detail::window_t window_;
+    bool windowed_;
+
+    cv::Mat sum_;
+};
+
+//
+// The per-pixel median of the last frames of the window:
+//
+struct window_median_t : detail::accumulator_t {
+    explicit window_median_t (size_t window = 15, int type = -1)
+        : detail::accumulator_t (type), window_ (window)
+    { }
+
+public:
+    void
+    operator() (const cv::Mat&);
+
+private:
+    void
+    materialize () const override;
+
+private:
+    detail::window_t window_;
+    mutable cv::Mat median_;
 };
 
 }
@@ -0,0 +1,76 @@
+#ifndef BS_EXECUTION_HPP
+#define BS_EXECUTION_HPP
+
+#include <bs/defs.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace bs {
+
+//
+// Where the parallel kernels of a model run: the number of threads (0 for the
+// OpenMP default, or the size of the core set), the set of cores, given or as
+// the cores of a NUMA node (any core if neither), and whether each thread is
+// pinned to one core of the set or floats over all of it:
+//
+//     bs::execution_t x { 4, { 8, 9, 10, 11 }, -1, bs::execution_t::PIN };
+//     bs::zivkovic_gmm_t model (4, .005, 15., 16., .7, .05, x);
+//
+struct execution_t {
+    enum pinning_t { FLOAT, PIN };
+
+    size_t threads = 0;
+    std::vector< int > cores;
+
+    int node = -1;
+    pinning_t pinning = FLOAT;
+
+public:
+    //
+    // The cores of the context, if any; those of the node are read from the
+    // kernel unless resolved:
+    //
+    std::vector< int >
+    core_set () const;
+
+    //
+    // The context with the cores of its node, if any, resolved into the core
+    // set, read once when a model is given the context rather than on every
+    // update:
+    //
+    execution_t
+    resolved () const;
+
+    //
+    // The cores of a NUMA node, as listed by the kernel (Linux):
+    //
+    static std::vector< int >
+    node_cores (int);
+};
+
+//
+// Applies an execution context to the parallel regions the calling thread
+// starts while the scope lives: their width and, on Linux, the affinity of
+// their threads. The threads of the team are set again only when the cores,
+// width or pinning differ from the last context applied, and back to the
+// affinity of the process under a context without cores; the calling thread
+// is set on entry and its affinity restored on exit, with the previous width.
+// The models open one around every update, the free kernels (lbp,
+// similarity, ...) run in the scope of their caller:
+//
+struct execution_scope_t {
+    explicit execution_scope_t (const execution_t&);
+    ~execution_scope_t ();
+
+    execution_scope_t (const execution_scope_t&) = delete;
+    execution_scope_t& operator= (const execution_scope_t&) = delete;
+
+private:
+    int previous_;
+    std::vector< int > saved_;
+};
+
+}
+
+#endif // BS_EXECUTION_HPP
@@ -1,49 +1,99 @@
 #include <bs/utils.hpp>
+#include <bs/detail/bootstrap.hpp>
 #include <bs/fgmm.hpp>
 
+#include <algorithm>
+#include <memory>
+
 namespace bs {
 
-template< typename T >
+template< typename F, typename T >
+void
+fgmm_base_t< F, T >::allocate (size_t n) {
+    const int node = execution_.node;
+
+    g_ = detail::numa_array_t< gaussian_t > (n * size_, node);
+    counts_ = detail::numa_array_t< unsigned > (n, node);
+    stamps_ = detail::numa_array_t< detail::decay_stamp_t > (n, node);
+}
+
+template< typename F, typename T >
 const cv::Mat&
-fgmm_base_t< T >::operator() (const cv::Mat& frame) {
-    mask_ = cv::Mat (frame.size (), CV_8U, cv::Scalar (255));
+fgmm_base_t< F, T >::operator() (const cv::Mat& frame) {
+    const execution_scope_t scope (execution_);
+
+    BS_ASSERT (frame.type () == detail::pixel_traits< T >::type);
+
+    mask_.create (frame.size (), CV_8U);
+    mask_.setTo (cv::Scalar (255));
 
     if (g_.empty ()) {
-        g_.resize (frame.total ());
+        allocate (frame.total ());
 
-        for (size_t i = 0; i < g_.size (); ++i) {
-            auto& g = g_ [i];
-            g.reserve (size_);
+        const auto stamp = decay_.stamp ();
 
-            const auto& src = frame.at< cv::Vec3b > (i);
-            g.resize (1UL, make_gaussian (src, variance_));
+        //
+        // First touch, with the schedule of the update loop:
+        //
+#pragma omp parallel for schedule (static)
+        for (size_t i = 0; i < frame.total (); ++i) {
+            const auto g = make_gaussian (frame.at< T > (i), variance_);
+
+            std::uninitialized_fill_n (g_.data () + i * size_, size_, g);
+
+            counts_ [i] = 1;
+            stamps_ [i] = stamp;
         }
 
         background_ = frame.clone ();
     }
     else {
-#pragma omp parallel for
+        decay_.advance ();
+
+#pragma omp parallel for schedule (static)
         for (size_t i = 0; i < frame.total (); ++i) {
-            const auto& src = frame.at< cv::Vec3b > (i);
+            const auto& src = frame.at< T > (i);
+            const auto x = detail::vec_from (src);
+
+            gaussian_t* const gs = g_.data () + i * size_;
+            auto& count = counts_ [i];
+
+            auto& stamp = stamps_ [i];
+
+            {
+                const double factor = decay_.rebase (stamp);
+
+                if (1. != factor) {
+                    std::for_each (gs, gs + count, [=](auto& g) {
+                            g.w *= factor; });
 
-            auto& gs = g_ [i];
+                    stamp.total = std::accumulate (
+                        gs, gs + count, 0., [](auto accum, const auto& g) {
+                            return accum + g.w; });
+                }
+            }
 
-            for_each (begin (gs), end (gs), [=](auto& g) {
+            std::for_each (gs, gs + count, [=](auto& g) {
                     g.g = g.w / g.s; });
 
-            sort (begin (gs), end (gs), [](const auto& g1, const auto& g2) {
+            std::sort (gs, gs + count, [](const auto& g1, const auto& g2) {
                     return g1.g > g2.g; });
 
             size_t n = 0;
 
+            const double weight_threshold = weight_threshold_ * stamp.total;
+
             for (double sum = 0.;
-                 n < gs.size () && sum < weight_threshold_; ++n) {
+                 n < count && sum < weight_threshold; ++n) {
                 sum += gs [n].w;
             }
 
-            int once = 0;
+            const double increment = decay_.increment (stamp);
+            double total = stamp.total + increment;
+
+            size_t j = 0;
 
-            for (size_t j = 0; j < gs.size (); ++j) {
+            for (; j < count; ++j) {
                 auto& g = gs [j];
 
                 auto& v = g.v;
@@ -52,64 +102,127 @@ fgmm_base_t< T >::operator() (const cv::Mat& frame) {
                 auto& m = g.m;
 
                 const double distance = sqrt (
-                    dot (f_ (cv::Vec3d (src), m, v, s, k_)));
-
-                if (0 == once && distance < variance_threshold_ * s &&
-                    1 == ++once) {
+                    dot (f_ (x, m, v, s, k_)));
 
+                if (distance < variance_threshold_ * s) {
                     if (j < n) {
                         mask_.at< unsigned char > (i) = 0;
-                        background_.at< cv::Vec3b > (i) = gs [0].m;
                     }
 
-                    const double r = alpha_ * w;
+                    const double r = alpha_ * w / stamp.total;
 
-                    w = (1. - alpha_) * w + alpha_;
+                    w += increment;
 
-                    m [0] += r * (src [0] - m [0]);
-                    m [1] += r * (src [1] - m [1]);
-                    m [2] += r * (src [2] - m [2]);
+                    m += r * (x - m);
 
-                    v += r * (dot (cv::Vec3d (src) - cv::Vec3d (m)) - v);
+                    v += r * (dot (x - m) - v);
                     s = sqrt (v);
-                }
-                else {
-                    w = (1. - alpha_) * w;
+
+                    break;
                 }
             }
 
-            if (!once) {
-                const auto& src = frame.at< cv::Vec3b > (i);
-
-                if (gs.size () < size_) {
-                    gs.emplace_back (make_gaussian (src, variance_, alpha_));
+            if (j == count) {
+                if (count < size_) {
+                    gs [count++] = make_gaussian (src, variance_, increment);
                 }
                 else {
-                    gs.back () = make_gaussian (src, variance_, alpha_);
+                    total -= gs [count - 1].w;
+                    gs [count - 1] = make_gaussian (src, variance_, increment);
                 }
             }
 
             {
-                sort (begin (gs), end (gs), [](const auto& g1, const auto& g2) {
+                std::sort (gs, gs + count, [](const auto& g1, const auto& g2) {
                         return g1.w > g2.w; });
 
-                auto last = find_if (begin (gs), end (gs), [=](auto& g) {
+                auto last = std::find_if (gs, gs + count, [=](auto& g) {
                     return g.w < 0; });
 
-                gs.erase (last, end (gs));
+                std::for_each (last, gs + count, [&](const auto& g) {
+                        total -= g.w; });
+
+                count = unsigned (last - gs);
             }
 
-            {
-                const auto normal = 1. / accumulate (
-                    begin (gs), end (gs), 0., [](auto accum, const auto& g) {
-                        return accum + g.w; });
+            //
+            // Weights are re-normalized lazily, see detail::lazy_decay_t:
+            //
+            stamp.total = total;
+        }
+
+        invalidate_background ();
+    }
+
+    return emit_mask ();
+}
+
+template< typename F, typename T >
+void
+fgmm_base_t< F, T >::bootstrap (const std::vector< cv::Mat >& frames) {
+    const execution_scope_t scope (execution_);
+
+    BS_ASSERT (!frames.empty ());
+
+    const auto& frame = frames.front ();
+
+    for (const auto& x : frames) {
+        BS_ASSERT (x.type () == detail::pixel_traits< T >::type);
+        BS_ASSERT (x.size () == frame.size ());
+    }
+
+    allocate (frame.total ());
+
+    const auto stamp = decay_.stamp ();
+
+    const double d = variance_threshold_ * variance_threshold_ * variance_;
+    const double n = frames.size ();
 
-                for_each (begin (gs), end (gs), [=](auto& g) { g.w *= normal; });
+#pragma omp parallel
+    {
+        std::vector< detail::batch_mode_t< T > > modes;
+
+#pragma omp for schedule (static)
+        for (size_t i = 0; i < frame.total (); ++i) {
+            detail::cluster_batch (frames, i, size_, d, modes);
+
+            gaussian_t* gs = g_.data () + i * size_;
+
+            double total = 0.;
+
+            for (const auto& mode : modes) {
+                const double v = mode.variance (variance_), w = mode.n / n;
+                const double s = sqrt (v);
+
+                *gs++ = gaussian_t { v, s, w, w / s, mode.m };
+
+                total += w;
             }
+
+            counts_ [i] = unsigned (modes.size ());
+
+            stamps_ [i] = stamp;
+            stamps_ [i].total = total;
         }
     }
 
-    return mask_;
+    background_.create (frame.size (), frame.type ());
+    mask_ = cv::Mat (frame.size (), CV_8U, cv::Scalar (0));
+
+    invalidate_background ();
+}
+
+template< typename F, typename T >
+void
+fgmm_base_t< F, T >::materialize () const {
+    //
+    // The mean of the most probable mode of each pixel:
+    //
+#pragma omp parallel for schedule (static)
+    for (size_t i = 0; i < counts_.size (); ++i) {
+        if (counts_ [i])
+            background_.at< T > (i) = detail::pixel_from< T > (g_ [i * size_].m);
+    }
 }
 
 } // namespace bs
@@ -3,6 +3,9 @@
 
 #include <bs/defs.hpp>
 #include <bs/detail/base.hpp>
+#include <bs/detail/decay.hpp>
+#include <bs/detail/numa.hpp>
+#include <bs/detail/pixel.hpp>
 
 #include <numeric>
 #include <vector>
@@ -24,48 +27,50 @@ namespace bs {
 // Gaussian primary membership function with uncertain mean:
 //
 struct mfum_t {
-    cv::Vec3d
-    operator() (const cv::Vec3d& x, const cv::Vec3d& y,
+    template< int N >
+    cv::Vec< double, N >
+    operator() (const cv::Vec< double, N >& x, const cv::Vec< double, N >& y,
                double v, double s, double k) {
         BS_ASSERT (v > 0);
         BS_ASSERT (s > 0);
         BS_ASSERT (k > 0);
 
-        const cv::Vec3d d = y - x;
+        const cv::Vec< double, N > d = y - x;
 
-        cv::Vec3d z;
+        cv::Vec< double, N > z;
 
-        z [0] = (x [0] < y [0] - k * s) || (x [0] > y [0] + k * s)
-            ? 2 * k * d [0] / s
-            : d [0] / (2 * v) + k * d [0] / s + k * k / 2;
+        for (int c = 0; c < N; ++c) {
+            //
+            // The third channel of the color kernel is scaled by the variance,
+            // as it always was:
+            //
+            const double q = 3 == N && 2 == c ? v : s;
 
-        z [1] = (x [1] < y [1] - k * s) || (x [1] > y [1] + k * s)
-            ? 2 * k * d [1] / s
-            : d [1] / (2 * v) + k * d [1] / s + k * k / 2;
-
-        z [2] = (x [2] < y [2] - k * s) || (x [2] > y [2] + k * s)
-            ? 2 * k * d [2] / s
-            : d [2] / (2 * v) + k * d [2] / v + k * k / 2;
+            z [c] = (x [c] < y [c] - k * s) || (x [c] > y [c] + k * s)
+                ? 2 * k * d [c] / s
+                : d [c] / (2 * v) + k * d [c] / q + k * k / 2;
+        }
 
         return z;
     }
 };
 
 struct mfuv_t {
-    cv::Vec3d
-    operator() (const cv::Vec3d& x, const cv::Vec3d& y,
+    template< int N >
+    cv::Vec< double, N >
+    operator() (const cv::Vec< double, N >& x, const cv::Vec< double, N >& y,
                 double v, double s, double k) {
         BS_ASSERT (v > 0);
         BS_ASSERT (s > 0);
         BS_ASSERT (k > 0);
 
-        const cv::Vec3d d = y - x;
+        const cv::Vec< double, N > d = y - x;
 
         return ((1 / (k * k) - k * k) / (2 * v)) * d.mul (d);
     }
 };
 
-template< typename F >
+template< typename F, typename T = cv::Vec3b >
 struct fgmm_base_t : detail::base_t {
     static constexpr auto default_modes = 4.;
     static constexpr auto default_alpha = .005;
@@ -75,81 +80,118 @@ struct fgmm_base_t : detail::base_t {
 
 public:
     explicit fgmm_base_t (
-        size_t n, double a, double v, double t, double w, double k, const F& f)
-        : size_ (n), alpha_ (a), variance_ (v), variance_threshold_ (t),
-          weight_threshold_ (w), k_ (k), f_ (f)
+        size_t n, double a, double v, double t, double w, double k, const F& f,
+        const execution_t& x = { })
+        : detail::base_t ({ }, { }, x),
+          size_ (n), alpha_ (a), variance_ (v), variance_threshold_ (t),
+          weight_threshold_ (w), k_ (k), decay_ (a), f_ (f)
         { }
 
 public:
     const cv::Mat&
     operator() (const cv::Mat&);
 
+    //
+    // Starts the mixtures from a batch of frames, clustered per pixel (see
+    // detail::cluster_batch), rather than from a single mode of the first
+    // frame:
+    //
+    void
+    bootstrap (const std::vector< cv::Mat >&);
+
+private:
+    void
+    materialize () const override;
+
 private:
     struct gaussian_t {
         double v, s, w, g;
-        cv::Vec3d m;
+        detail::pixel_vec_t< T > m;
     };
 
     gaussian_t
-    make_gaussian (const cv::Vec3b& src, double v, double s, double a) const {
-        return gaussian_t { v, s, a, a / s, cv::Vec3d (src) };
+    make_gaussian (const T& src, double v, double s, double a) const {
+        return gaussian_t { v, s, a, a / s, detail::vec_from (src) };
     }
 
     gaussian_t
-    make_gaussian (const cv::Vec3b& src, double v, double a) const {
+    make_gaussian (const T& src, double v, double a) const {
         return make_gaussian (src, v, sqrt (v), a);
     }
 
     gaussian_t
-    make_gaussian (const cv::Vec3b& src, double v) const {
+    make_gaussian (const T& src, double v) const {
         return make_gaussian (src, v, sqrt (v), 1.);
     }
 
+    void
+    allocate (size_t);
 
 private:
     size_t size_;
     double alpha_, variance_, variance_threshold_,weight_threshold_, k_;
-    std::vector< std::vector< gaussian_t > > g_;
+
+    //
+    // The modes of pixel i are the first counts_ [i] of the size_ slots at
+    // g_ [i * size_], on the node of the execution context, if any:
+    //
+    detail::numa_array_t< gaussian_t > g_;
+    detail::numa_array_t< unsigned > counts_;
+
+    detail::lazy_decay_t decay_;
+    detail::numa_array_t< detail::decay_stamp_t > stamps_;
 
     F f_;
 };
 
-struct fgmm_um_t : fgmm_base_t< mfum_t > {
-    using base_type = fgmm_base_t< mfum_t >;
+template< typename T >
+struct basic_fgmm_um_t : fgmm_base_t< mfum_t, T > {
+    using base_type = fgmm_base_t< mfum_t, T >;
 
 public:
     static constexpr auto default_k = 2.5;
 
 public:
-    explicit fgmm_um_t (
+    explicit basic_fgmm_um_t (
         size_t n = base_type::default_modes,
         double a = base_type::default_alpha,
         double v = base_type::default_variance,
         double t = base_type::default_variance_threshold,
         double w = base_type::default_weight_threshold,
-        double k = default_k)
-        : base_type (n, a, v, t, w, k, mfum_t ())
+        double k = default_k,
+        const execution_t& x = { })
+        : base_type (n, a, v, t, w, k, mfum_t (), x)
         { }
 };
 
-struct fgmm_uv_t : fgmm_base_t< mfuv_t > {
-    using base_type = fgmm_base_t< mfuv_t >;
+template< typename T >
+struct basic_fgmm_uv_t : fgmm_base_t< mfuv_t, T > {
+    using base_type = fgmm_base_t< mfuv_t, T >;
 
 public:
     static constexpr auto default_k = 1.5;
 
 public:
-    explicit fgmm_uv_t (
+    explicit basic_fgmm_uv_t (
         size_t n = base_type::default_modes,
         double a = base_type::default_alpha,
         double v = base_type::default_variance,
         double t = base_type::default_variance_threshold,
         double w = base_type::default_weight_threshold,
-        double k = default_k)
-        : base_type (n, a, v, t, w, k, mfuv_t ())
+        double k = default_k,
+        const execution_t& x = { })
+        : base_type (n, a, v, t, w, k, mfuv_t (), x)
         { }
 };
 
+using fgmm_um_t        = basic_fgmm_um_t< cv::Vec3b >;
+using fgmm_um_gray_t   = basic_fgmm_um_t< unsigned char >;
+using fgmm_um_gray16_t = basic_fgmm_um_t< unsigned short >;
+
+using fgmm_uv_t        = basic_fgmm_uv_t< cv::Vec3b >;
+using fgmm_uv_gray_t   = basic_fgmm_uv_t< unsigned char >;
+using fgmm_uv_gray16_t = basic_fgmm_uv_t< unsigned short >;
+
 } // namespace bs
 
 #include <bs/fgmm.cc>
@@ -11,13 +11,18 @@
 
 namespace bs {
 
-struct frames_iterator : boost::iterator_facade <
-    frames_iterator, cv::Mat, std::forward_iterator_tag > {
-
-    frames_iterator () : pvc_ { }, pmat_ { } { }
-
-    frames_iterator (cv::VideoCapture* pvc, cv::Mat* pmat)
-        : pvc_(pvc), pmat_(pmat) {
+//
+// Iterates over the frames of any source that extracts frames with >>, e.g.,
+// cv::VideoCapture or bs::shm_reader_t; an empty frame ends the sequence:
+//
+template< typename Source >
+struct basic_frames_iterator : boost::iterator_facade <
+    basic_frames_iterator< Source >, cv::Mat, std::forward_iterator_tag > {
+
+    basic_frames_iterator () : psrc_ { }, pmat_ { } { }
+
+    basic_frames_iterator (Source* psrc, cv::Mat* pmat)
+        : psrc_(psrc), pmat_(pmat) {
         increment ();
     }
 
@@ -25,13 +30,13 @@ private:
     friend class boost::iterator_core_access;
 
     void increment () {
-        *pvc_ >> *pmat_;
+        *psrc_ >> *pmat_;
 
         if (pmat_->empty ())
-            *this = frames_iterator { };
+            *this = basic_frames_iterator { };
     }
 
-    bool equal (frames_iterator const& that) const {
+    bool equal (basic_frames_iterator const& that) const {
         return pmat_ == that.pmat_;
     }
 
@@ -39,27 +44,36 @@ private:
         return *pmat_;
     }
 
-    cv::VideoCapture* pvc_;
+    Source* psrc_;
     cv::Mat* pmat_;
 };
 
-using frames_range_base = ranges::iterator_range< frames_iterator >;
+template< typename Source >
+using basic_frames_range_base = ranges::iterator_range<
+    basic_frames_iterator< Source > >;
 
 struct frames_range_data {
     cv::Mat mat_;
 };
 
-struct frames_range : private frames_range_data, frames_range_base {
-    explicit frames_range (cv::VideoCapture& vc)
-        : frames_range_base (
-              frames_iterator { &vc, &mat_ },
-              frames_iterator { })
+template< typename Source >
+struct basic_frames_range
+    : private frames_range_data, basic_frames_range_base< Source > {
+    explicit basic_frames_range (Source& src)
+        : basic_frames_range_base< Source > (
+              basic_frames_iterator< Source > { &src, &mat_ },
+              basic_frames_iterator< Source > { })
     { }
 };
 
-static inline frames_range
-getframes_from (cv::VideoCapture& vc) {
-    return frames_range { vc };
+using frames_iterator = basic_frames_iterator< cv::VideoCapture >;
+using frames_range_base = basic_frames_range_base< cv::VideoCapture >;
+using frames_range = basic_frames_range< cv::VideoCapture >;
+
+template< typename Source >
+inline basic_frames_range< Source >
+getframes_from (Source& src) {
+    return basic_frames_range< Source > { src };
 }
 
 }
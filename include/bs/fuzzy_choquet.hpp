@@ -4,6 +4,7 @@
 #include <bs/defs.hpp>
 #include <bs/detail/base.hpp>
 
+#include <utility>
 #include <vector>
 
 #include <opencv2/core/mat.hpp>
@@ -24,15 +25,44 @@ namespace bs {
 struct fuzzy_choquet_t : detail::base_t {
     explicit fuzzy_choquet_t (
         const cv::Mat&, double = .01, double = .67,
-        const std::vector< double >& g = { .6, .3, .1 });
+        const std::vector< double >& g = { .6, .3, .1 },
+        const execution_t& = { });
 
 public:
     const cv::Mat&
     operator() (const cv::Mat&);
 
+    //
+    // Starts from the mean of a batch of frames, in the color space of the
+    // model:
+    //
+    void
+    bootstrap (const std::vector< cv::Mat >&);
+
+    //
+    // Computes the similarities with an approximate reciprocal, to within
+    // 1e-5 relative error:
+    //
+    void
+    approximate (bool arg) {
+        approximate_ = arg;
+    }
+
 private:
     double alpha_, threshold_;
     std::vector< double > g_;
+
+    //
+    // The range of the similarity of the previous frame:
+    //
+    std::pair< double, double > range_;
+
+    bool approximate_;
+
+    //
+    // Scratch planes, kept across frames:
+    //
+    cv::Mat color_, frame_, fg_, bg_, h_, i_, s_, t_;
 };
 
 }
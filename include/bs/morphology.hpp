@@ -0,0 +1,83 @@
+#ifndef BS_MORPHOLOGY_HPP
+#define BS_MORPHOLOGY_HPP
+
+#include <bs/defs.hpp>
+#include <bs/compact_mask.hpp>
+
+#include <initializer_list>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+namespace bs {
+
+//
+// Binary morphology on bit-packed masks, 64 pixels per word, with the 3x3
+// square as structuring element. Outside the mask is background, except for
+// the erosion, which does not erode from the border (as OpenCV). The
+// destination must not be the source:
+//
+void
+erode (const packed_mask_t&, packed_mask_t&);
+
+void
+dilate (const packed_mask_t&, packed_mask_t&);
+
+//
+// Foreground where at least 5 of the 9 pixels of the window are:
+//
+void
+majority (const packed_mask_t&, packed_mask_t&);
+
+//
+// Hysteresis: the pixels of the mask (low threshold) connected, with the given
+// connectivity (4 or 8), to a pixel of the seeds (high threshold):
+//
+void
+reconstruct (const packed_mask_t&, const packed_mask_t&, packed_mask_t&,
+             int = 8);
+
+//
+// A cleanup stage for the mask of a model, a chain of the above:
+//
+//     bs::morphology_t cleanup { bs::morphology_t::OPEN };
+//     const auto& mask = cleanup (model (frame));
+//
+struct morphology_t {
+    enum op_t { ERODE, DILATE, OPEN, CLOSE, MAJORITY };
+
+public:
+    morphology_t (std::initializer_list< op_t >);
+
+public:
+    const packed_mask_t&
+    operator() (const packed_mask_t&);
+
+    //
+    // Packs the mask, applies the chain and unpacks the result:
+    //
+    const cv::Mat&
+    operator() (const cv::Mat&);
+
+    const packed_mask_t&
+    packed_mask () const {
+        return *result_;
+    }
+
+    const cv::Mat&
+    mask () const {
+        return mask_;
+    }
+
+private:
+    std::vector< op_t > ops_;
+
+    packed_mask_t src_, buf_ [2];
+    const packed_mask_t* result_;
+
+    cv::Mat mask_;
+};
+
+}
+
+#endif // BS_MORPHOLOGY_HPP
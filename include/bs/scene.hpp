@@ -0,0 +1,119 @@
+#ifndef BS_SCENE_HPP
+#define BS_SCENE_HPP
+
+#include <bs/defs.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+namespace bs {
+
+//
+// The parameters of a synthetic scene: the size and type (CV_8UC1 or CV_8UC3)
+// of the frames and their number (0 for no end); the moving sprites; the
+// amplitude of the illumination drift, a fraction of the brightness, and its
+// period in frames; the amplitude of the sensor noise, in levels; the regions
+// of the background that flicker between two textures, and that wave:
+//
+struct scene_options_t {
+    cv::Size size { 320, 240 };
+    int type = CV_8UC3;
+
+    size_t frames = 0;
+    size_t sprites = 4;
+
+    double drift = .1;
+    size_t period = 300;
+
+    int noise = 4;
+
+    size_t flicker = 0, waving = 0;
+
+    unsigned seed = 1;
+};
+
+//
+// A synthetic video with its ground truth, for the tests and the benchmarks:
+// a textured background under a slow illumination drift and sensor noise, a
+// number of textured sprites bouncing across it, and optionally multimodal
+// regions of the background, flickering or waving. The ground truth mask is
+// the cover of the sprites; flicker and waves are background.
+//
+// A frame is a function of its index and the seed only, rendered from tables
+// built at construction, in parallel over the rows, well above 1 GB/s:
+//
+//     bs::scene_options_t options;
+//     options.frames = 300;
+//     options.flicker = 2;
+//
+//     bs::scene_t scene (options);
+//
+//     for (cv::Mat frame, truth; scene.next (frame, truth); )
+//         ... model (frame) ... truth ...
+//
+struct scene_t {
+    explicit scene_t (const scene_options_t& = { });
+
+public:
+    //
+    // Renders frame t and its ground truth mask (CV_8U, 255 over the sprites),
+    // reusing the storage of the arguments:
+    //
+    void
+    render (size_t, cv::Mat&, cv::Mat&) const;
+
+    //
+    // Renders the next frame, false past the last one:
+    //
+    bool
+    next (cv::Mat&, cv::Mat&);
+
+    //
+    // The first frames, without the masks:
+    //
+    std::vector< cv::Mat >
+    frames (size_t) const;
+
+    //
+    // The background, without drift, noise or sprites:
+    //
+    const cv::Mat&
+    background () const {
+        return background_;
+    }
+
+    const scene_options_t&
+    options () const {
+        return options_;
+    }
+
+private:
+    struct sprite_t {
+        cv::Mat texture;
+        cv::Point origin, velocity;
+    };
+
+    struct region_t {
+        enum kind_t { FLICKER, WAVING } kind;
+        cv::Rect rect;
+    };
+
+    scene_options_t options_;
+    size_t index_ = 0;
+
+    //
+    // The background, the texture the flickering regions switch to, and the
+    // table the noise of the rows is drawn from:
+    //
+    cv::Mat background_, alternate_;
+    std::vector< signed char > noise_;
+
+    std::vector< sprite_t > sprites_;
+    std::vector< region_t > regions_;
+};
+
+}
+
+#endif // BS_SCENE_HPP
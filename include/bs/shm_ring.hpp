@@ -0,0 +1,126 @@
+#ifndef BS_SHM_RING_HPP
+#define BS_SHM_RING_HPP
+
+#include <bs/defs.hpp>
+
+#include <cstdint>
+#include <string>
+
+#include <opencv2/core/mat.hpp>
+
+namespace bs {
+
+//
+// A single-producer, single-consumer ring of frames in POSIX shared memory,
+// for passing frames, masks or backgrounds between processes without copying
+// them over a socket. The slots are fixed-size; the matrices handed out are
+// headers over the shared pages. The producer and the consumer block on
+// futexes in the shared header when the ring is full or empty, respectively,
+// and wake up periodically to check that the other side is still there; a
+// side that dies ends the stream. Linux only.
+//
+namespace detail {
+
+struct shm_header_t;
+struct shm_slot_t;
+
+struct shm_mapping_t {
+    shm_mapping_t () = default;
+    shm_mapping_t (const std::string&, size_t, size_t);
+    explicit shm_mapping_t (const std::string&);
+
+    shm_mapping_t (shm_mapping_t&&);
+    shm_mapping_t& operator= (shm_mapping_t&&);
+
+    ~shm_mapping_t ();
+
+public:
+    shm_header_t* header () const;
+
+    shm_slot_t* slot (size_t) const;
+    unsigned char* data (size_t) const;
+
+private:
+    std::string name_;
+    void* addr_ { };
+    size_t size_ { };
+    bool owner_ { };
+};
+
+}
+
+struct shm_writer_t {
+    //
+    // Creates (and owns) the named segment, with the given number of slots,
+    // each capable of holding a frame of the given size in bytes:
+    //
+    explicit shm_writer_t (const std::string&, size_t, size_t);
+    ~shm_writer_t ();
+
+public:
+    //
+    // Waits for a free slot and returns a header over it, to be filled in
+    // place and then published; throws std::system_error (EPIPE) if the ring
+    // is full and its reader gone:
+    //
+    cv::Mat
+    acquire (int, int, int);
+
+    void
+    publish ();
+
+    //
+    // Copies a frame into the next slot and publishes it:
+    //
+    shm_writer_t&
+    operator<< (const cv::Mat&);
+
+    //
+    // Marks the end of the stream; the reader sees an empty frame once the
+    // ring is drained:
+    //
+    void
+    close ();
+
+private:
+    detail::shm_mapping_t mapping_;
+    uint32_t head_;
+    bool acquired_;
+};
+
+struct shm_reader_t {
+    //
+    // Attaches to the named segment; throws std::system_error (EBUSY) if
+    // another reader is attached:
+    //
+    explicit shm_reader_t (const std::string&);
+    ~shm_reader_t ();
+
+public:
+    //
+    // Releases the slot of the previous frame, waits for the next one and
+    // points the matrix at it; the matrix stays valid until the next read. At
+    // the end of the stream, closed or its writer gone, the matrix is left
+    // empty and read returns false:
+    //
+    bool
+    read (cv::Mat&);
+
+    shm_reader_t&
+    operator>> (cv::Mat& frame) {
+        return read (frame), *this;
+    }
+
+private:
+    void
+    release ();
+
+private:
+    detail::shm_mapping_t mapping_;
+    uint32_t tail_;
+    bool holding_;
+};
+
+}
+
+#endif // BS_SHM_RING_HPP
@@ -4,6 +4,8 @@
 #include <bs/defs.hpp>
 #include <bs/detail/base.hpp>
 
+#include <vector>
+
 #include <opencv2/core/mat.hpp>
 
 namespace bs {
@@ -40,15 +42,31 @@ namespace bs {
 // }
 
 struct sigma_delta_t : detail::base_t {
-    explicit sigma_delta_t (const cv::Mat&, size_t = 2, size_t = 2, size_t = 255);
+    explicit sigma_delta_t (
+        const cv::Mat&, size_t = 2, size_t = 2, size_t = 255,
+        const execution_t& = { });
 
 public:
     const cv::Mat&
     operator() (const cv::Mat&);
 
+    //
+    // Starts from the median of a batch of frames, and from their mean
+    // absolute deviation from it as variance:
+    //
+    void
+    bootstrap (const std::vector< cv::Mat >&);
+
 private:
     cv::Mat m_, d_, v_, q_;
+
+    //
+    // Scratch planes, kept across frames:
+    //
+    cv::Mat a_, b_, c_;
+
     size_t n_, Vmin_, Vmax_;
+    double max_;
 };
 
 }
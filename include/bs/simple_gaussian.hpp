@@ -3,6 +3,7 @@
 
 #include <bs/defs.hpp>
 #include <bs/detail/base.hpp>
+#include <bs/detail/pixel.hpp>
 
 #include <vector>
 
@@ -10,18 +11,38 @@
 
 namespace bs {
 
-struct simple_gaussian_t : detail::base_t {
-    explicit simple_gaussian_t (const cv::Mat&, float = .0001, float = .25);
+template< typename T >
+struct basic_simple_gaussian_t : detail::base_t {
+    explicit basic_simple_gaussian_t (
+        const cv::Mat&, float = .0001, float = .25, const execution_t& = { });
 
 public:
     const cv::Mat&
     operator() (const cv::Mat&);
 
+    //
+    // Starts from the per-channel mean and variance of a batch of frames:
+    //
+    void
+    bootstrap (const std::vector< cv::Mat >&);
+
+private:
+    void
+    materialize () const override;
+
 private:
-    cv::Mat m_, v_;
+    //
+    // Planar state, one CV_32F plane per channel: the running mean, in [0, 1],
+    // and the reciprocal of the running variance:
+    //
+    std::vector< cv::Mat > m_, r_;
     float alpha_, threshold_;
 };
 
+using simple_gaussian_t        = basic_simple_gaussian_t< cv::Vec3b >;
+using simple_gaussian_gray_t   = basic_simple_gaussian_t< unsigned char >;
+using simple_gaussian_gray16_t = basic_simple_gaussian_t< unsigned short >;
+
 }
 
 #endif // BS_SIMPLE_GAUSSIAN_HPP
@@ -2,6 +2,7 @@
 #define BS_TEMPORAL_MEDIAN_HPP
 
 #include <bs/defs.hpp>
+#include <bs/blobs.hpp>
 #include <bs/detail/base.hpp>
 
 #include <opencv2/core/mat.hpp>
@@ -34,25 +35,63 @@ namespace bs {
 //  keywords = {background suppression, people detection and tracking, shadow
 //  detection},
 // }
+// The frames are 8-bit or 16-bit gray; the mask is 8-bit regardless. By
+// default, the low-threshold pixels next to a high-threshold one are kept;
+// with hysteresis, the whole low-threshold regions that contain one are.
 //
 
 struct temporal_median_t : detail::base_t {
     explicit temporal_median_t (
-        const cv::Mat&, size_t = 9, size_t = 16, size_t = 30, size_t = 60);
+        const cv::Mat&, size_t = 9, size_t = 16, size_t = 30, size_t = 60,
+        bool = false, const execution_t& = { });
 
     const cv::Mat&
     operator() (const cv::Mat&);
 
+    //
+    // Fills the history from a batch of frames, the most recent of them, at
+    // most the frame interval apart, and starts from their median:
+    //
+    void
+    bootstrap (const std::vector< cv::Mat >&);
+
 private:
-    cv::Mat
-    calculate_median () const;
+    //
+    // Replaces the background with the median of the history and itself:
+    //
+    template< typename T >
+    void
+    calculate_median ();
+
+    //
+    // Copies a frame into the history, into the buffer of the frame it evicts
+    // once the history is full:
+    //
+    void
+    push_history (const cv::Mat&);
+
+    template< typename T >
+    void
+    merge_masks (const cv::Mat&);
 
-    cv::Mat
-    merge_masks (const cv::Mat&, const cv::Mat&);
+    template< typename T >
+    void
+    hysteresis (const cv::Mat&);
 
 private:
     boost::circular_buffer< cv::Mat > history_;
     size_t lo_, hi_, frame_interval_, frame_counter_;
+
+    bool hysteresis_;
+    blobs_t components_;
+    std::vector< unsigned char > seeded_;
+
+    //
+    // Scratch, kept across frames: the difference to the background, and the
+    // pixel histories, one per thread:
+    //
+    cv::Mat diff_;
+    std::vector< unsigned short > buf_;
 };
 
 }
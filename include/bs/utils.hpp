@@ -2,9 +2,10 @@
 #define BS_UTILS_HPP
 
 #include <bs/defs.hpp>
+#include <bs/cpu.hpp>
 #include <bs/detail/threshold.hpp>
 
-#include <chrono>
+#include <algorithm>
 #include <functional>
 
 #include <opencv2/imgproc.hpp>
@@ -12,8 +13,50 @@
 namespace bs {
 namespace detail {
 
+//
+// Area downscaling of 8-bit gray or BGR frames to the given size, converted to
+// gray in the same pass or keeping the channels; see src/utils.cpp:
+//
+void
+area_gray (const cv::Mat&, cv::Mat&, cv::Size);
+
+void
+area_resize (const cv::Mat&, cv::Mat&, cv::Size);
+
+inline cv::Size
+scaled_size (const cv::Mat& frame, double factor) {
+    return cv::Size (
+        (std::max) (cv::saturate_cast< int > (frame.cols * factor), 1),
+        (std::max) (cv::saturate_cast< int > (frame.rows * factor), 1));
+}
+
+inline bool
+is_area_downscale (const cv::Mat& frame, double factor) {
+    return factor < 1 && (
+        frame.type () == CV_8UC1 || frame.type () == CV_8UC3);
+}
+
+BS_INLINE void
+ohta_row (const cv::Vec3b* src, cv::Vec3b* dst, int n) {
+    for (int j = 0; j < n; ++j) {
+        const auto& s = src [j];
+        auto& d = dst [j];
+
+        d [0] = cv::saturate_cast< unsigned char > ((s [0] + s [1] + s [2]) / 3.);
+        d [1] = cv::saturate_cast< unsigned char > ((s [2] - s [0]) / 2.);
+        d [2] = cv::saturate_cast< unsigned char > ((2 * s [1] - s [2] + s [0]) / 4.);
+    }
+}
+
+BS_CLONES (ohta_row)
+
 inline cv::Mat
 scale_frame (cv::Mat& frame, double factor) {
+    if (is_area_downscale (frame, factor)) {
+        cv::Mat tiny;
+        return area_gray (frame, tiny, scaled_size (frame, factor)), tiny;
+    }
+
     cv::Mat bw;
     cv::cvtColor (frame, bw, cv::COLOR_BGR2GRAY);
 
@@ -35,12 +78,38 @@ dot (const cv::Vec3d& x) {
     return dot (x, x);
 }
 
+template< typename T, int N >
+inline T
+dot (const cv::Vec< T, N >& x, const cv::Vec< T, N >& y) {
+    T result = x [0] * y [0];
+
+    for (int i = 1; i < N; ++i)
+        result += x [i] * y [i];
+
+    return result;
+}
+
+template< typename T, int N >
+inline T
+dot (const cv::Vec< T, N >& x) {
+    return dot (x, x);
+}
+
+//
+// The helpers that compute a matrix come in pairs: one writing into a given
+// destination, which keeps its buffer across calls when the size and type
+// match (see cv::Mat::create), and one returning a new matrix:
+//
+inline void
+border (const cv::Mat& src, cv::Mat& dst, size_t n = 1) {
+    cv::copyMakeBorder (
+        src, dst, n, n, n, n, cv::BORDER_CONSTANT, 0);
+}
+
 inline cv::Mat
 border (const cv::Mat& src, size_t n = 1) {
     cv::Mat dst;
-    cv::copyMakeBorder (
-        src, dst, n, n, n, n, cv::BORDER_CONSTANT, 0);
-    return dst;
+    return border (src, dst, n), dst;
 }
 
 inline cv::Mat
@@ -56,10 +125,21 @@ minmax (const cv::Mat& src) {
     return { a, b };
 }
 
+inline void
+convert (const cv::Mat& src, cv::Mat& dst, int t, double a = 1, double b = 0) {
+    src.convertTo (dst, t, a, b);
+}
+
 inline cv::Mat
 convert (const cv::Mat& src, int t, double a = 1, double b = 0) {
     cv::Mat dst;
-    return src.convertTo (dst, t, a, b), dst;
+    return convert (src, dst, t, a, b), dst;
+}
+
+inline void
+float_from (const cv::Mat& src, cv::Mat& dst,
+            double scale = 1. / 255, double offset = 0.) {
+    convert (src, dst, CV_32F, scale, offset);
 }
 
 inline cv::Mat
@@ -67,20 +147,54 @@ float_from (const cv::Mat& src, double scale = 1. / 255, double offset = 0.) {
     return convert (src, CV_32F, scale, offset);
 }
 
+inline void
+double_from (const cv::Mat& src, cv::Mat& dst,
+             double scale = 1. / 255, double offset = 0.) {
+    convert (src, dst, CV_64F, scale, offset);
+}
+
 inline cv::Mat
 double_from (const cv::Mat& src, double scale = 1. / 255, double offset = 0.) {
     return convert (src, CV_64F, scale, offset);
 }
 
+inline void
+mono_from (const cv::Mat& src, cv::Mat& dst,
+           double scale = 255., double offset = 0.) {
+    convert (src, dst, CV_8U, scale, offset);
+}
+
 inline cv::Mat
 mono_from (const cv::Mat& src, double scale = 255., double offset = 0.) {
     return convert (src, CV_8U, scale, offset);
 }
 
+//
+// A binary mask of any unsigned depth as the 255/0 CV_8U mask the models emit;
+// the returning one shares an 8-bit source:
+//
+inline void
+mask_from (const cv::Mat& src, cv::Mat& dst) {
+    if (CV_8U == src.depth ())
+        src.copyTo (dst);
+    else
+        convert (src, dst, CV_8U);
+}
+
+inline cv::Mat
+mask_from (const cv::Mat& src) {
+    return CV_8U == src.depth () ? src : convert (src, CV_8U);
+}
+
+inline void
+median_blur (const cv::Mat& src, cv::Mat& dst, int size = 3) {
+    cv::medianBlur (src, dst, size);
+}
+
 inline cv::Mat
 median_blur (const cv::Mat& src, int size = 3) {
     cv::Mat dst;
-    return cv::medianBlur (src, dst, size), dst;
+    return median_blur (src, dst, size), dst;
 }
 
 inline cv::Mat
@@ -88,43 +202,48 @@ blur (const cv::Mat& src) {
     return bs::median_blur (src);
 }
 
+inline void
+multiply (const cv::Mat& lhs, const cv::Mat& rhs, cv::Mat& dst) {
+    cv::multiply (lhs, rhs, dst);
+}
+
 inline cv::Mat
 multiply (const cv::Mat& lhs, const cv::Mat& rhs) {
     cv::Mat dst;
-    return cv::multiply (lhs, rhs, dst), dst;
+    return multiply (lhs, rhs, dst), dst;
 }
 
-inline cv::Mat
-convert_ohta (const cv::Mat& src) {
+inline void
+convert_ohta (const cv::Mat& src, cv::Mat& dst) {
     BS_ASSERT (src.type () == CV_8UC3);
 
-    cv::Mat dst (src.size (), src.type ());
+    dst.create (src.size (), src.type ());
 
-    for (size_t i = 0; i < src.total (); ++i) {
-        const auto& s = src.at< cv::Vec3b > (i);
-
-        auto& d = dst.at< cv::Vec3b > (i);
-
-        d [0] = cv::saturate_cast< unsigned char > ((s [0] + s [1] + s [2]) / 3.);
-        d [1] = cv::saturate_cast< unsigned char > ((s [2] - s [0]) / 2.);
-        d [2] = cv::saturate_cast< unsigned char > ((2 * s [1] - s [2] + s [0]) / 4.);
-    }
+    for (int i = 0; i < src.rows; ++i)
+        detail::ohta_row_dispatch (
+            src.ptr< cv::Vec3b > (i), dst.ptr< cv::Vec3b > (i), src.cols);
+}
 
-    return dst;
+inline cv::Mat
+convert_ohta (const cv::Mat& src) {
+    cv::Mat dst;
+    return convert_ohta (src, dst), dst;
 }
 
 constexpr int COLOR_BGR2OHTA = cv::COLOR_COLORCVT_MAX + 1;
 
+inline void
+convert_color (const cv::Mat& src, cv::Mat& dst, int type) {
+    if (type == COLOR_BGR2OHTA)
+        convert_ohta (src, dst);
+    else
+        cv::cvtColor (src, dst, type);
+}
+
 inline cv::Mat
 convert_color (const cv::Mat& src, int type) {
     cv::Mat dst;
-
-    if (type == COLOR_BGR2OHTA)
-        return convert_ohta (src);
-    else {
-        cv::cvtColor (src, dst, type);
-        return dst;
-    }
+    return convert_color (src, dst, type), dst;
 }
 
 inline int
@@ -137,21 +256,36 @@ gray_from (const cv::Vec3b& arg) {
     return gray_from (arg [0], arg [1], arg [2]);
 }
 
+inline void
+gray_from (const cv::Mat& src, cv::Mat& dst) {
+    convert_color (src, dst, cv::COLOR_BGR2GRAY);
+}
+
 inline cv::Mat
 gray_from (const cv::Mat& src) {
     return convert_color (src, cv::COLOR_BGR2GRAY);
 }
 
+inline void
+power_of (const cv::Mat& src, cv::Mat& dst, double power) {
+    cv::pow (src, power, dst);
+}
+
 inline cv::Mat
 power_of (const cv::Mat& src, double power) {
     cv::Mat dst;
-    return cv::pow (src, power, dst), dst;
+    return power_of (src, dst, power), dst;
+}
+
+inline void
+absdiff (const cv::Mat& lhs, const cv::Mat& rhs, cv::Mat& dst) {
+    cv::absdiff (lhs, rhs, dst);
 }
 
 inline cv::Mat
 absdiff (const cv::Mat& lhs, const cv::Mat& rhs) {
     cv::Mat dst;
-    return cv::absdiff (lhs, rhs, dst), dst;
+    return absdiff (lhs, rhs, dst), dst;
 }
 
 inline cv::Mat
@@ -162,15 +296,20 @@ scale_frame (cv::Mat& src, size_t to = 512) {
 inline cv::Mat
 resize_frame (cv::Mat& src, double factor) {
     cv::Mat dst;
+
+    if (detail::is_area_downscale (src, factor))
+        return detail::area_resize (src, dst, detail::scaled_size (src, factor)), dst;
+
     cv::resize (src, dst, cv::Size (), factor, factor, cv::INTER_LINEAR);
     return dst;
 }
 
-inline cv::Mat
-threshold (const cv::Mat& src, double threshold_ = 1., double maxval = 255.,
-           int type = cv::THRESH_BINARY) {
-    cv::Mat dst;
-
+//
+// In place if dst is src:
+//
+inline void
+threshold (const cv::Mat& src, cv::Mat& dst, double threshold_ = 1.,
+           double maxval = 255., int type = cv::THRESH_BINARY) {
     switch (src.type ()) {
     case CV_8U:
     case CV_32F:
@@ -178,7 +317,7 @@ threshold (const cv::Mat& src, double threshold_ = 1., double maxval = 255.,
         break;
 
 #define T(x, y) case x:                                                 \
-        dst = detail::threshold< y > (src, threshold_, maxval, type);   \
+        detail::threshold< y > (src, dst, threshold_, maxval, type);    \
         break
 
         T (CV_16U, unsigned short int);
@@ -190,34 +329,14 @@ threshold (const cv::Mat& src, double threshold_ = 1., double maxval = 255.,
     default:
         throw std::invalid_argument ("unsupported array type");
     }
-
-    return dst;
 }
 
-struct frame_delay {
-    frame_delay (size_t value = 40)
-        : value_ (value),
-          begin_ (std::chrono::high_resolution_clock::now ())
-    { }
-
-    bool wait_for_key (int key) const  {
-        using namespace std::chrono;
-
-        int passed = duration_cast< milliseconds > (
-            high_resolution_clock::now () - begin_).count ();
-
-        int remaining = value_ - passed;
-
-        if (remaining < 1)
-            remaining = 1;
-
-        return key == cv::waitKey (remaining);
-    }
-
-private:
-    int value_;
-    std::chrono::high_resolution_clock::time_point begin_;
-};
+inline cv::Mat
+threshold (const cv::Mat& src, double threshold_ = 1., double maxval = 255.,
+           int type = cv::THRESH_BINARY) {
+    cv::Mat dst;
+    return threshold (src, dst, threshold_, maxval, type), dst;
+}
 
 }
 
@@ -3,6 +3,9 @@
 
 #include <bs/defs.hpp>
 #include <bs/detail/base.hpp>
+#include <bs/detail/decay.hpp>
+#include <bs/detail/numa.hpp>
+#include <bs/detail/pixel.hpp>
 
 #include <vector>
 
@@ -22,7 +25,8 @@ namespace bs {
 // }
 //
 
-struct zivkovic_gmm_t : detail::base_t {
+template< typename T >
+struct basic_zivkovic_gmm_t : detail::base_t {
     static constexpr auto default_modes = 4.;
     static constexpr auto default_alpha = .005;
     static constexpr auto default_variance = 16.;
@@ -31,33 +35,62 @@ struct zivkovic_gmm_t : detail::base_t {
     static constexpr auto default_bias = .05;
 
 public:
-    explicit zivkovic_gmm_t (
+    explicit basic_zivkovic_gmm_t (
         size_t = default_modes,
         double = default_alpha,
         double = default_variance_threshold,
         double = default_variance,
         double = default_weight_threshold,
-        double = default_bias);
+        double = default_bias,
+        const execution_t& = { });
 
 public:
     const cv::Mat&
     operator() (const cv::Mat&);
 
+    //
+    // Starts the mixtures from a batch of frames, clustered per pixel (see
+    // detail::cluster_batch), rather than from a single mode of the first
+    // frame:
+    //
+    void
+    bootstrap (const std::vector< cv::Mat >&);
+
+private:
+    void
+    materialize () const override;
+
 private:
     struct gaussian_t {
         double v, w, s;
-        cv::Vec3d m;
+        detail::pixel_vec_t< T > m;
     };
 
     gaussian_t
-    default_gaussian (const cv::Vec3b& = cv::Vec3b ());
+    default_gaussian (const T& = T ());
+
+    void
+    allocate (size_t);
 
 private:
     size_t size_;
     double alpha_, variance_threshold_, variance_, weight_threshold_, bias_;
-    std::vector< std::vector< gaussian_t > > g_;
+
+    //
+    // The modes of pixel i are the first counts_ [i] of the size_ slots at
+    // g_ [i * size_], on the node of the execution context, if any:
+    //
+    detail::numa_array_t< gaussian_t > g_;
+    detail::numa_array_t< unsigned > counts_;
+
+    detail::lazy_decay_t decay_;
+    detail::numa_array_t< detail::decay_stamp_t > stamps_;
 };
 
+using zivkovic_gmm_t        = basic_zivkovic_gmm_t< cv::Vec3b >;
+using zivkovic_gmm_gray_t   = basic_zivkovic_gmm_t< unsigned char >;
+using zivkovic_gmm_gray16_t = basic_zivkovic_gmm_t< unsigned short >;
+
 }
 
 #endif // BS_ZIVKOVIC_GMM_HPP
@@ -1,14 +1,20 @@
 #include <bs/utils.hpp>
 #include <bs/adaptive_median.hpp>
+#include <bs/ewma.hpp>
 
 #include <opencv2/imgproc.hpp>
 
 namespace bs {
 
-adaptive_median_t::adaptive_median_t (const cv::Mat& b, size_t i, size_t t)
-    : detail::base_t (b), frame_interval_ (i), frame_counter_ { },
-      threshold_ (t)
-{ }
+adaptive_median_t::adaptive_median_t (
+    const cv::Mat& b, size_t i, size_t t, const execution_t& x)
+    : detail::base_t (b.clone (), { }, x),
+      frame_interval_ (i), frame_counter_ { }, threshold_ (t) {
+    //
+    // 8-bit or 16-bit gray; the mask is 8-bit regardless:
+    //
+    BS_ASSERT (b.type () == CV_8UC1 || b.type () == CV_16UC1);
+}
 
 //
 // ... Image differencing between the current frame and a reference image gave
@@ -32,19 +38,47 @@ adaptive_median_t::adaptive_median_t (const cv::Mat& b, size_t i, size_t t)
 
 const cv::Mat&
 adaptive_median_t::operator() (const cv::Mat& frame) {
-    mask_ = threshold (absdiff (frame, background_), threshold_);
+    const execution_scope_t scope (execution_);
+
+    BS_ASSERT (frame.type () == background_.type ());
+
+    absdiff (frame, background_, a_);
+    threshold (a_, a_, threshold_);
+
+    mask_from (a_, mask_);
 
     if (0 == frame_counter_++ % frame_interval_) {
         //
         // Update the reference (background) frame:
         //
-        cv::Mat add_mask = threshold (frame - background_, 0, 1);
-        cv::Mat sub_mask = threshold (background_ - frame, 0, 1);
+        cv::subtract (frame, background_, a_);
+        threshold (a_, a_, 0, 1);
+
+        cv::subtract (background_, frame, b_);
+        threshold (b_, b_, 0, 1);
+
+        cv::add (background_, a_, background_);
+        cv::subtract (background_, b_, background_);
+    }
+
+    return emit_mask ();
+}
+
+void
+adaptive_median_t::bootstrap (const std::vector< cv::Mat >& frames) {
+    const execution_scope_t scope (execution_);
+
+    BS_ASSERT (!frames.empty ());
+
+    window_median_t f (frames.size ());
 
-        background_ = background_ + add_mask - sub_mask;
+    for (const auto& frame : frames) {
+        BS_ASSERT (frame.type () == background_.type ());
+        f (frame);
     }
 
-    return mask_;
+    f.value ().copyTo (background_);
+    frame_counter_ = 0;
 }
 
 }
@@ -0,0 +1,282 @@
+#include <bs/arena.hpp>
+
+#include <cstdint>
+#include <new>
+using namespace std;
+
+#if defined (__linux__)
+#  include <sys/mman.h>
+#else
+#  include <cstdlib>
+#endif // __linux__
+
+namespace bs {
+
+namespace {
+
+//
+// A 2MB-aligned mapping of a multiple of 2MB, of huge pages if any are
+// reserved, else of pages the kernel may back with transparent huge pages:
+//
+void*
+map_slabs (size_t size) {
+    const size_t align = arena_t::slab_size;
+
+#if defined (__linux__)
+#  if defined (MAP_HUGETLB) && defined (MAP_HUGE_2MB)
+    void* p = mmap (
+        0, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+
+    if (MAP_FAILED != p)
+        return p;
+#  endif // MAP_HUGETLB
+
+    //
+    // Over-map and trim to the alignment the transparent huge pages need:
+    //
+    void* q = mmap (
+        0, size + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+        -1, 0);
+
+    if (MAP_FAILED == q)
+        throw bad_alloc ();
+
+    char* first = static_cast< char* > (q);
+    char* aligned = reinterpret_cast< char* > (
+        (reinterpret_cast< uintptr_t > (first) + align - 1) & ~(align - 1));
+
+    if (aligned != first)
+        munmap (first, aligned - first);
+
+    if (const size_t tail = (first + size + align) - (aligned + size))
+        munmap (aligned + size, tail);
+
+#  if defined (MADV_HUGEPAGE)
+    madvise (aligned, size, MADV_HUGEPAGE);
+#  endif // MADV_HUGEPAGE
+
+    return aligned;
+#else
+    void* p = aligned_alloc (align, size);
+
+    if (0 == p)
+        throw bad_alloc ();
+
+    return p;
+#endif // __linux__
+}
+
+void
+unmap_slabs (void* p, size_t size) {
+#if defined (__linux__)
+    munmap (p, size);
+#else
+    free (p);
+#endif // __linux__
+}
+
+}
+
+arena_t::arena_t () { }
+
+arena_t::~arena_t () {
+    for (const auto& mapping : mappings_)
+        unmap_slabs (mapping.first, mapping.second);
+}
+
+cv::UMatData*
+arena_t::allocate (int dims, const int* sizes, int type, void* data,
+                   size_t* step, cv::AccessFlag, cv::UMatUsageFlags) const {
+    //
+    // The layout, as cv::Mat's own allocator computes it:
+    //
+    size_t total = CV_ELEM_SIZE (type);
+
+    for (int i = dims - 1; i >= 0; --i) {
+        if (step) {
+            if (data && step [i] != CV_AUTOSTEP)
+                total = step [i];
+            else
+                step [i] = total;
+        }
+
+        total *= sizes [i];
+    }
+
+    const lock_guard< mutex > lock (mutex_);
+
+    auto u = new (get (sizeof (cv::UMatData), counters_.header_misses))
+        cv::UMatData (this);
+
+    ++counters_.headers;
+
+    if (data) {
+        u->data = u->origdata = static_cast< unsigned char* > (data);
+        u->flags |= cv::UMatData::USER_ALLOCATED;
+    }
+    else {
+        u->data = u->origdata = static_cast< unsigned char* > (
+            get (total, counters_.misses));
+        ++counters_.allocations;
+    }
+
+    u->size = total;
+
+    return u;
+}
+
+bool
+arena_t::allocate (cv::UMatData* u, cv::AccessFlag, cv::UMatUsageFlags) const {
+    return 0 != u;
+}
+
+void
+arena_t::deallocate (cv::UMatData* u) const {
+    if (0 == u)
+        return;
+
+    BS_ASSERT (0 == u->urefcount && 0 == u->refcount);
+
+    const lock_guard< mutex > lock (mutex_);
+
+    if (0 == (u->flags & cv::UMatData::USER_ALLOCATED)) {
+        put (u->origdata, u->size);
+        ++counters_.deallocations;
+    }
+
+    u->~UMatData ();
+    put (u, sizeof (cv::UMatData));
+}
+
+arena_t::counters_t
+arena_t::counters () const {
+    const lock_guard< mutex > lock (mutex_);
+    return counters_;
+}
+
+void
+arena_t::trim () {
+    const lock_guard< mutex > lock (mutex_);
+
+    for (; large_; ) {
+        block_t* p = large_;
+        large_ = p->next;
+
+        const size_t size = p->size;
+
+        for (auto iter = mappings_.begin (); iter != mappings_.end (); ++iter) {
+            if (iter->first == p) {
+                mappings_.erase (iter);
+                break;
+            }
+        }
+
+        unmap_slabs (p, size);
+        counters_.mapped -= size;
+    }
+}
+
+//
+// A block of at least n bytes, from the free lists, else new; the latter
+// counted in misses:
+//
+void*
+arena_t::get (size_t n, size_t& misses) const {
+    size_t c = min_class;
+    for (; c <= max_class && (size_t (1) << c) < n; ++c) ;
+
+    if (c <= max_class) {
+        auto& head = free_ [c - min_class];
+
+        if (head) {
+            block_t* p = head;
+            head = p->next;
+            return p;
+        }
+
+        ++misses;
+        return carve (size_t (1) << c);
+    }
+
+    //
+    // Larger than a slab, recycled by (rounded) size:
+    //
+    const size_t size = (n + slab_size - 1) / slab_size * slab_size;
+
+    for (block_t** p = &large_; *p; p = &(*p)->next) {
+        if ((*p)->size == size) {
+            block_t* q = *p;
+            *p = q->next;
+            return q;
+        }
+    }
+
+    ++misses;
+
+    void* p = map_slabs (size);
+
+    mappings_.emplace_back (p, size);
+    counters_.mapped += size;
+
+    return p;
+}
+
+void
+arena_t::put (void* p, size_t n) const {
+    size_t c = min_class;
+    for (; c <= max_class && (size_t (1) << c) < n; ++c) ;
+
+    block_t* block = static_cast< block_t* > (p);
+
+    if (c <= max_class) {
+        auto& head = free_ [c - min_class];
+
+        block->next = head;
+        head = block;
+    }
+    else {
+        block->size = (n + slab_size - 1) / slab_size * slab_size;
+
+        block->next = large_;
+        large_ = block;
+    }
+}
+
+void*
+arena_t::carve (size_t size) const {
+    if (size_t (last_ - first_) < size) {
+        //
+        // The tail of the current slab goes to the free lists of the smaller
+        // classes, largest first; all blocks stay 64-byte aligned:
+        //
+        for (size_t c = max_class + 1; c-- > min_class; ) {
+            for (; size_t (last_ - first_) >= (size_t (1) << c);
+                 first_ += size_t (1) << c) {
+                put (first_, size_t (1) << c);
+            }
+        }
+
+        first_ = static_cast< char* > (map_slabs (slab_size));
+        last_ = first_ + slab_size;
+
+        mappings_.emplace_back (first_, slab_size);
+        counters_.mapped += slab_size;
+    }
+
+    void* p = first_;
+    first_ += size;
+
+    return p;
+}
+
+arena_scope_t::arena_scope_t (arena_t& arena)
+    : previous_ (cv::Mat::getDefaultAllocator ()) {
+    cv::Mat::setDefaultAllocator (&arena);
+}
+
+arena_scope_t::~arena_scope_t () {
+    cv::Mat::setDefaultAllocator (previous_);
+}
+
+}
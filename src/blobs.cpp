@@ -0,0 +1,267 @@
+#include <bs/blobs.hpp>
+
+#include <algorithm>
+#include <cstring>
+using namespace std;
+
+namespace bs {
+
+namespace {
+
+//
+// Skips background pixels eight at a time; masks are mostly empty:
+//
+inline int
+skip_zeros (const unsigned char* p, int j, int n) {
+    for (uint64_t x; j + 8 <= n; j += 8) {
+        memcpy (&x, p + j, sizeof x);
+
+        if (x)
+            break;
+    }
+
+    for (; j < n && 0 == p [j]; ++j) ;
+
+    return j;
+}
+
+inline int
+skip_ones (const unsigned char* p, int j, int n) {
+    for (; j < n && p [j]; ++j) ;
+    return j;
+}
+
+struct accumulator_t {
+    size_t area;
+    double x, y;
+    int left, top, right, bottom;
+};
+
+}
+
+/* explicit */
+blobs_t::blobs_t (size_t min_area, size_t max_area, int connectivity,
+                  size_t tiles)
+    : min_area_ (min_area), max_area_ (max_area),
+      offset_ (8 == connectivity ? 1 : 0), tiles_ (tiles ? tiles : 1)
+{
+    BS_ASSERT (4 == connectivity || 8 == connectivity);
+}
+
+inline uint32_t
+blobs_t::find (uint32_t i) {
+    //
+    // Path halving:
+    //
+    for (; parents_ [i] != i; i = parents_ [i])
+        parents_ [i] = parents_ [parents_ [i]];
+
+    return i;
+}
+
+inline void
+blobs_t::unite (uint32_t i, uint32_t j) {
+    i = find (i);
+    j = find (j);
+
+    //
+    // The root is always the run with the smallest index, i.e., the first one
+    // in scan order:
+    //
+    if (i < j)
+        parents_ [j] = i;
+    else
+        parents_ [i] = j;
+}
+
+//
+// Labels the runs of rows [first, last) into the runs and parents of band n;
+// parents are local to the band:
+//
+void
+blobs_t::label (const cv::Mat& mask, size_t n, int first, int last) {
+    auto& runs = band_runs_ [n];
+    auto& parents = band_parents_ [n];
+
+    runs.clear ();
+    parents.clear ();
+
+    auto find = [&](uint32_t i) {
+        for (; parents [i] != i; i = parents [i])
+            parents [i] = parents [parents [i]];
+        return i;
+    };
+
+    const int cols = mask.cols;
+
+    size_t prev = 0, prev_end = 0;
+
+    for (int i = first; i < last; ++i) {
+        const unsigned char* p = mask.ptr< unsigned char > (i);
+
+        const size_t row_begin = runs.size ();
+
+        for (int j = skip_zeros (p, 0, cols); j < cols;
+             j = skip_zeros (p, j, cols)) {
+            const int begin = j;
+            j = skip_ones (p, j, cols);
+
+            const uint32_t k = runs.size ();
+
+            runs.push_back (run_t { i, begin, j });
+            parents.push_back (k);
+
+            //
+            // Previous row runs that end before this one cannot overlap any of
+            // the following runs either:
+            //
+            for (; prev < prev_end && runs [prev].end + offset_ <= begin; ++prev) ;
+
+            for (size_t l = prev; l < prev_end && runs [l].begin < j + offset_; ++l) {
+                const uint32_t a = find (k), b = find (l);
+
+                if (a < b)
+                    parents [b] = a;
+                else
+                    parents [a] = b;
+            }
+        }
+
+        prev = row_begin;
+        prev_end = runs.size ();
+    }
+}
+
+//
+// Joins the runs in [a, a_end) with the runs in [b, b_end), from two
+// consecutive rows, in the global arrays:
+//
+void
+blobs_t::merge (size_t a, size_t a_end, size_t b, size_t b_end) {
+    for (; b < b_end; ++b) {
+        const auto& run = runs_ [b];
+
+        for (; a < a_end && runs_ [a].end + offset_ <= run.begin; ++a) ;
+
+        for (size_t l = a; l < a_end && runs_ [l].begin < run.end + offset_; ++l)
+            unite (b, l);
+    }
+}
+
+const std::vector< blob_t >&
+blobs_t::operator() (const cv::Mat& mask) {
+    BS_ASSERT (mask.type () == CV_8UC1);
+
+    const size_t tiles = (min) (tiles_, size_t ((max) (mask.rows, 1)));
+
+    band_runs_.resize (tiles);
+    band_parents_.resize (tiles);
+
+    //
+    // Band n covers rows [rows * n / tiles, rows * (n + 1) / tiles):
+    //
+    auto band_row = [&](size_t n) {
+        return int (mask.rows * n / tiles);
+    };
+
+#pragma omp parallel for if (tiles > 1)
+    for (size_t n = 0; n < tiles; ++n) {
+        label (mask, n, band_row (n), band_row (n + 1));
+    }
+
+    //
+    // Concatenate the bands, with their parents offset into the global
+    // arrays:
+    //
+    runs_.clear ();
+    parents_.clear ();
+
+    vector< size_t > offsets (tiles + 1, 0);
+
+    for (size_t n = 0; n < tiles; ++n) {
+        const size_t offset = runs_.size ();
+        offsets [n] = offset;
+
+        runs_.insert (runs_.end (), band_runs_ [n].begin (), band_runs_ [n].end ());
+
+        for (auto parent : band_parents_ [n])
+            parents_.push_back (offset + parent);
+    }
+
+    offsets [tiles] = runs_.size ();
+
+    //
+    // Merge at the seams, the last row of a band with the first row of the
+    // next:
+    //
+    for (size_t n = 1; n < tiles; ++n) {
+        const int row = band_row (n);
+
+        size_t a_end = offsets [n], a = a_end;
+
+        for (; a > offsets [n - 1] && runs_ [a - 1].row == row - 1; --a) ;
+
+        size_t b = offsets [n], b_end = b;
+
+        for (; b_end < offsets [n + 1] && runs_ [b_end].row == row; ++b_end) ;
+
+        merge (a, a_end, b, b_end);
+    }
+
+    //
+    // Roots precede their runs, one pass assigns the labels and accumulates
+    // the statistics:
+    //
+    labels_.resize (runs_.size ());
+
+    vector< accumulator_t > accs;
+
+    for (uint32_t i = 0; i < runs_.size (); ++i) {
+        const uint32_t root = find (i);
+
+        if (root == i) {
+            labels_ [i] = accs.size ();
+            accs.push_back (accumulator_t {
+                    0, 0., 0.,
+                    (numeric_limits< int >::max) (),
+                    (numeric_limits< int >::max) (),
+                    (numeric_limits< int >::min) (),
+                    (numeric_limits< int >::min) () });
+        }
+        else
+            labels_ [i] = labels_ [root];
+
+        const auto& run = runs_ [i];
+        auto& acc = accs [labels_ [i]];
+
+        const size_t n = run.end - run.begin;
+
+        acc.area += n;
+        acc.x += .5 * n * (run.begin + run.end - 1);
+        acc.y += double (n) * run.row;
+
+        acc.left = (min) (acc.left, run.begin);
+        acc.right = (max) (acc.right, run.end);
+        acc.top = (min) (acc.top, run.row);
+        acc.bottom = (max) (acc.bottom, run.row + 1);
+    }
+
+    components_ = accs.size ();
+
+    blobs_.clear ();
+
+    for (const auto& acc : accs) {
+        if (acc.area < min_area_ || acc.area > max_area_)
+            continue;
+
+        blobs_.push_back (blob_t {
+                cv::Rect (acc.left, acc.top,
+                          acc.right - acc.left, acc.bottom - acc.top),
+                acc.area,
+                cv::Point2d (acc.x / acc.area, acc.y / acc.area) });
+    }
+
+    return blobs_;
+}
+
+}
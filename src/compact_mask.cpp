@@ -0,0 +1,240 @@
+#include <bs/compact_mask.hpp>
+
+#include <cstring>
+using namespace std;
+
+namespace bs {
+
+namespace {
+
+constexpr uint64_t lo7 = 0x7F7F7F7F7F7F7F7FULL;
+constexpr uint64_t hi1 = 0x8080808080808080ULL;
+
+//
+// Gathers the non-zero-ness of eight bytes into the low eight bits, the byte
+// at the lowest address into bit 0:
+//
+inline unsigned
+gather8 (const unsigned char* p) {
+    uint64_t x;
+    memcpy (&x, p, sizeof x);
+
+    x = (((x & lo7) + lo7) | x) & hi1;
+
+    return ((x >> 7) * 0x0102040810204080ULL) >> 56;
+}
+
+//
+// The eight bytes, 255/0, for the bits of a byte:
+//
+struct expand_table_t {
+    expand_table_t () {
+        for (unsigned i = 0; i < 256; ++i) {
+            uint64_t x = 0;
+
+            for (unsigned j = 0; j < 8; ++j)
+                if (i & (1U << j))
+                    x |= 0xFFULL << (8 * j);
+
+            value [i] = x;
+        }
+    }
+
+    uint64_t value [256];
+};
+
+const expand_table_t expand_table;
+
+inline void
+pack_row (const unsigned char* p, int cols, uint64_t* q) {
+    int j = 0;
+
+    for (; j + 64 <= cols; j += 64, ++q) {
+        uint64_t word = 0;
+
+        for (int k = 0; k < 8; ++k)
+            word |= uint64_t (gather8 (p + j + 8 * k)) << (8 * k);
+
+        *q = word;
+    }
+
+    if (j < cols) {
+        uint64_t word = 0;
+
+        for (int k = 0; j + k < cols; ++k)
+            word |= uint64_t (0 != p [j + k]) << k;
+
+        *q = word;
+    }
+}
+
+inline void
+unpack_row (const uint64_t* p, int cols, unsigned char* q) {
+    int j = 0;
+
+    for (; j + 64 <= cols; j += 64, ++p) {
+        for (int k = 0; k < 8; ++k) {
+            const uint64_t x = expand_table.value [(*p >> (8 * k)) & 0xFF];
+            memcpy (q + j + 8 * k, &x, sizeof x);
+        }
+    }
+
+    for (int k = 0; j + k < cols; ++k)
+        q [j + k] = (*p >> k) & 1 ? 255 : 0;
+}
+
+//
+// Calls f (begin, end) for the foreground spans of a row of bytes:
+//
+template< typename F >
+inline void
+for_each_span (const unsigned char* p, int cols, F f) {
+    for (int j = 0; j < cols; ) {
+        for (uint64_t x; j + 8 <= cols; j += 8) {
+            memcpy (&x, p + j, sizeof x);
+
+            if (x)
+                break;
+        }
+
+        for (; j < cols && 0 == p [j]; ++j) ;
+
+        if (j == cols)
+            break;
+
+        const int begin = j;
+        for (; j < cols && p [j]; ++j) ;
+
+        f (begin, j);
+    }
+}
+
+//
+// Same, for a row of bits:
+//
+template< typename F >
+inline void
+for_each_span (const uint64_t* p, size_t stride, F f) {
+    int begin = -1;
+
+    for (size_t k = 0; k < stride; ++k) {
+        //
+        // Search for a set bit, to begin a span, or for a clear bit, to end
+        // the current one:
+        //
+        uint64_t x = begin < 0 ? p [k] : ~p [k];
+
+        while (x) {
+            const int j = __builtin_ctzll (x);
+
+            if (begin < 0)
+                begin = 64 * k + j;
+            else {
+                f (begin, 64 * k + j);
+                begin = -1;
+            }
+
+            x = ~x & (~0ULL << j);
+        }
+    }
+
+    if (begin >= 0)
+        f (begin, 64 * stride);
+}
+
+template< typename Row >
+inline void
+encode_rows (int rows, int cols, rle_mask_t& dst, Row row) {
+    dst.rows = rows;
+    dst.cols = cols;
+    dst.offsets.resize (rows + 1);
+
+    //
+    // Count the spans of each row, then fill them in place:
+    //
+#pragma omp parallel for
+    for (int i = 0; i < rows; ++i) {
+        uint32_t n = 0;
+        row (i, [&](int, int) { ++n; });
+        dst.offsets [i + 1] = n;
+    }
+
+    dst.offsets [0] = 0;
+
+    for (int i = 0; i < rows; ++i)
+        dst.offsets [i + 1] += dst.offsets [i];
+
+    dst.spans.resize (dst.offsets [rows]);
+
+#pragma omp parallel for
+    for (int i = 0; i < rows; ++i) {
+        auto* q = dst.spans.data () + dst.offsets [i];
+
+        row (i, [&](int begin, int end) {
+            *q++ = rle_mask_t::span_t { uint32_t (begin), uint32_t (end) };
+        });
+    }
+}
+
+}
+
+void
+pack (const cv::Mat& src, packed_mask_t& dst) {
+    BS_ASSERT (src.type () == CV_8UC1);
+
+    dst.create (src.rows, src.cols);
+
+#pragma omp parallel for
+    for (int i = 0; i < src.rows; ++i)
+        pack_row (src.ptr< unsigned char > (i), src.cols, dst.row (i));
+}
+
+void
+unpack (const packed_mask_t& src, cv::Mat& dst) {
+    dst.create (src.rows, src.cols, CV_8U);
+
+#pragma omp parallel for
+    for (int i = 0; i < src.rows; ++i)
+        unpack_row (src.row (i), src.cols, dst.ptr< unsigned char > (i));
+}
+
+void
+encode (const cv::Mat& src, rle_mask_t& dst) {
+    BS_ASSERT (src.type () == CV_8UC1);
+
+    encode_rows (src.rows, src.cols, dst, [&](int i, auto f) {
+        for_each_span (src.ptr< unsigned char > (i), src.cols, f);
+    });
+}
+
+void
+encode (const packed_mask_t& src, rle_mask_t& dst) {
+    encode_rows (src.rows, src.cols, dst, [&](int i, auto f) {
+        for_each_span (src.row (i), src.stride, f);
+    });
+}
+
+void
+decode (const rle_mask_t& src, cv::Mat& dst) {
+    dst.create (src.rows, src.cols, CV_8U);
+
+#pragma omp parallel for
+    for (int i = 0; i < src.rows; ++i) {
+        unsigned char* p = dst.ptr< unsigned char > (i);
+
+        size_t j = 0;
+
+        for (auto k = src.offsets [i]; k < src.offsets [i + 1]; ++k) {
+            const auto& span = src.spans [k];
+
+            memset (p + j, 0, span.begin - j);
+            memset (p + span.begin, 255, span.end - span.begin);
+
+            j = span.end;
+        }
+
+        memset (p + j, 0, src.cols - j);
+    }
+}
+
+}
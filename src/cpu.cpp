@@ -0,0 +1,76 @@
+#include <bs/cpu.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+using namespace std;
+
+namespace bs {
+
+namespace {
+
+cpu_tier_t
+host_tier () {
+#if defined (__GNUC__) && defined (__x86_64__)
+    __builtin_cpu_init ();
+
+    if (__builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512bw"))
+        return CPU_AVX512;
+
+    if (__builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma"))
+        return CPU_AVX2;
+
+    if (__builtin_cpu_supports ("sse4.1"))
+        return CPU_SSE41;
+#endif // __GNUC__ && __x86_64__
+
+    return CPU_SSE2;
+}
+
+cpu_tier_t
+env_tier (cpu_tier_t tier) {
+    const char* s = getenv ("BS_CPU");
+
+    if (0 == s)
+        return tier;
+
+    for (auto x : { CPU_SSE2, CPU_SSE41, CPU_AVX2, CPU_AVX512 })
+        if (0 == strcmp (s, cpu_tier_name (x)))
+            return (min) (x, tier);
+
+    return tier;
+}
+
+const cpu_tier_t host_ = host_tier ();
+
+//
+// Detected at load, before the kernels run:
+//
+atomic< cpu_tier_t > tier_ { env_tier (host_) };
+
+}
+
+cpu_tier_t
+cpu_tier () {
+    return tier_.load (memory_order_relaxed);
+}
+
+void
+cpu_tier (cpu_tier_t arg) {
+    tier_.store ((min) (arg, host_), memory_order_relaxed);
+}
+
+const char*
+cpu_tier_name (cpu_tier_t arg) {
+    switch (arg) {
+    case CPU_SSE2:   return "sse2";
+    case CPU_SSE41:  return "sse4.1";
+    case CPU_AVX2:   return "avx2";
+    case CPU_AVX512: return "avx512";
+    default:
+        return "unknown";
+    }
+}
+
+}
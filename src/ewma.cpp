@@ -0,0 +1,125 @@
+#include <bs/ewma.hpp>
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#include <opencv2/imgproc.hpp>
+
+namespace bs {
+
+namespace {
+
+template< typename T >
+void
+median_of (const detail::window_t& window, cv::Mat& dst) {
+    const size_t n = window.size ();
+    const cv::Mat& first = window [0];
+
+    dst.create (first.size (), first.type ());
+
+    const int cols = first.cols * first.channels ();
+
+#pragma omp parallel
+    {
+        vector< const T* > rows (n);
+        vector< T > buf (n);
+
+#pragma omp for
+        for (int i = 0; i < first.rows; ++i) {
+            for (size_t k = 0; k < n; ++k)
+                rows [k] = window [k].ptr< T > (i);
+
+            T* d = dst.ptr< T > (i);
+
+            for (int j = 0; j < cols; ++j) {
+                for (size_t k = 0; k < n; ++k)
+                    buf [k] = rows [k][j];
+
+                nth_element (buf.begin (), buf.begin () + n / 2, buf.end ());
+                d [j] = buf [n / 2];
+            }
+        }
+    }
+}
+
+}
+
+void
+ewma_t::operator() (const cv::Mat& src) {
+    //
+    // The first frame is copied, never aliased, into the float state:
+    //
+    if (state_.empty ())
+        src.convertTo (state_, CV_MAKETYPE (CV_32F, src.channels ()));
+    else {
+        BS_ASSERT (src.size () == state_.size ());
+        BS_ASSERT (src.channels () == state_.channels ());
+
+        cv::accumulateWeighted (src, state_, alpha_);
+    }
+
+    updated (src);
+}
+
+void
+ewma_t::materialize () const {
+    state_.convertTo (value_, target_);
+}
+
+void
+window_mean_t::operator() (const cv::Mat& src) {
+    if (sum_.empty ())
+        sum_ = cv::Mat::zeros (src.size (), CV_MAKETYPE (CV_32F, src.channels ()));
+
+    BS_ASSERT (src.size () == sum_.size ());
+    BS_ASSERT (src.channels () == sum_.channels ());
+
+    if (windowed_) {
+        if (const cv::Mat* p = window_.next ())
+            cv::subtract (sum_, *p, sum_, cv::noArray (), sum_.type ());
+
+        window_.push (src);
+    }
+
+    cv::accumulate (src, sum_);
+    updated (src);
+}
+
+void
+window_mean_t::materialize () const {
+    const size_t n = windowed_ ? window_.size () : size ();
+    sum_.convertTo (value_, target_, 1. / n);
+}
+
+void
+window_median_t::operator() (const cv::Mat& src) {
+    window_.push (src);
+    updated (src);
+}
+
+void
+window_median_t::materialize () const {
+    const cv::Mat& first = window_ [0];
+
+    //
+    // Computed directly into the value, i.e., into the buffer of the previous
+    // one (see accumulator_t::value), when the background is of the type of
+    // the frames, and converted from a scratch median otherwise:
+    //
+    cv::Mat& dst = first.type () == target_ ? value_ : median_;
+
+    switch (first.depth ()) {
+    case CV_8U:  median_of< unsigned char >  (window_, dst); break;
+    case CV_16U: median_of< unsigned short > (window_, dst); break;
+    case CV_32F: median_of< float >          (window_, dst); break;
+
+    default:
+        throw std::invalid_argument ("unsupported array type");
+    }
+
+    if (&dst != &value_)
+        median_.convertTo (value_, target_);
+}
+
+}
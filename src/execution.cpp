@@ -0,0 +1,224 @@
+#include <bs/execution.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+using namespace std;
+
+#if defined (_OPENMP)
+#  include <omp.h>
+#endif // _OPENMP
+
+#if defined (__linux__)
+#  include <sched.h>
+#endif // __linux__
+
+namespace bs {
+
+namespace {
+
+//
+// Parses a kernel CPU list, e.g., 0-3,8,10-11:
+//
+vector< int >
+parse_cpulist (const string& s) {
+    vector< int > cores;
+
+    istringstream ss (s);
+
+    for (string range; getline (ss, range, ','); ) {
+        int first, last;
+        char dash;
+
+        istringstream rs (range);
+
+        if (!(rs >> first))
+            continue;
+
+        if (!(rs >> dash >> last))
+            last = first;
+
+        for (int i = first; i <= last; ++i)
+            cores.push_back (i);
+    }
+
+    return cores;
+}
+
+#if defined (__linux__)
+
+//
+// The cores the calling thread may run on:
+//
+vector< int >
+get_affinity () {
+    cpu_set_t set;
+    CPU_ZERO (&set);
+
+    vector< int > cores;
+
+    if (0 == sched_getaffinity (0, sizeof set, &set)) {
+        for (int i = 0; i < CPU_SETSIZE; ++i)
+            if (CPU_ISSET (i, &set))
+                cores.push_back (i);
+    }
+
+    return cores;
+}
+
+void
+set_affinity (const int* first, const int* last) {
+    cpu_set_t set;
+    CPU_ZERO (&set);
+
+    for (; first != last; ++first)
+        if (0 <= *first && *first < CPU_SETSIZE)
+            CPU_SET (*first, &set);
+
+    //
+    // Best effort, e.g., cores outside the cgroup of the process are refused:
+    //
+    sched_setaffinity (0, sizeof set, &set);
+}
+
+#  if defined (_OPENMP)
+
+//
+// The affinity of the process, as the library loads, before any context is
+// applied:
+//
+const vector< int > process_cores_ = get_affinity ();
+
+//
+// The cores, width and pinning last applied to the threads of the team of the
+// calling thread (each thread starting parallel regions has its own team); no
+// cores, the affinity of the process:
+//
+struct applied_t {
+    vector< int > cores;
+    int threads;
+    execution_t::pinning_t pinning;
+
+    bool
+    operator== (const applied_t& other) const {
+        return cores == other.cores && (cores.empty () || (
+            threads == other.threads && pinning == other.pinning));
+    }
+};
+
+thread_local applied_t applied_ { { }, 0, execution_t::FLOAT };
+
+//
+// Sets the affinity of the threads of a team this wide, other than the calling
+// one, for a core set (the affinity of the process if empty):
+//
+void
+apply (const applied_t& arg, int width) {
+    const vector< int >& cores = arg.cores.empty () ? process_cores_ : arg.cores;
+
+    const int* p = cores.data ();
+    const size_t size = cores.size ();
+
+    if (0 == size)
+        return;
+
+    const bool pin = !arg.cores.empty () && execution_t::PIN == arg.pinning;
+
+#pragma omp parallel num_threads (width)
+    {
+        const int i = omp_get_thread_num ();
+
+        if (i && pin)
+            set_affinity (p + i % size, p + i % size + 1);
+        else if (i)
+            set_affinity (p, p + size);
+    }
+}
+
+#  endif // _OPENMP
+#endif // __linux__
+
+}
+
+vector< int >
+execution_t::node_cores (int node) {
+    ifstream in (
+        "/sys/devices/system/node/node" + to_string (node) + "/cpulist");
+
+    string s;
+    getline (in, s);
+
+    return parse_cpulist (s);
+}
+
+vector< int >
+execution_t::core_set () const {
+    if (!cores.empty ())
+        return cores;
+
+    if (node >= 0)
+        return node_cores (node);
+
+    return { };
+}
+
+execution_t
+execution_t::resolved () const {
+    execution_t x = *this;
+
+    if (x.cores.empty () && x.node >= 0)
+        x.cores = node_cores (x.node);
+
+    return x;
+}
+
+execution_scope_t::execution_scope_t (const execution_t& arg) : previous_ () {
+#if defined (_OPENMP)
+    previous_ = omp_get_max_threads ();
+
+    const auto cores = arg.core_set ();
+
+    const int n = arg.threads
+        ? int (arg.threads) : cores.empty () ? previous_ : int (cores.size ());
+
+    omp_set_num_threads (n);
+
+#  if defined (__linux__)
+    const applied_t next { cores, n, arg.pinning };
+
+    if (!(next == applied_)) {
+        //
+        // Back to the affinity of the process, the whole team of the last
+        // context is reset:
+        //
+        apply (next, cores.empty () ? (std::max) (n, applied_.threads) : n);
+        applied_ = next;
+    }
+
+    if (!cores.empty ()) {
+        saved_ = get_affinity ();
+
+        const int* p = cores.data ();
+
+        if (execution_t::PIN == arg.pinning)
+            set_affinity (p, p + 1);
+        else
+            set_affinity (p, p + cores.size ());
+    }
+#  endif // __linux__
+#endif // _OPENMP
+}
+
+execution_scope_t::~execution_scope_t () {
+#if defined (_OPENMP)
+    omp_set_num_threads (previous_);
+#endif // _OPENMP
+
+#if defined (__linux__)
+    if (!saved_.empty ())
+        set_affinity (saved_.data (), saved_.data () + saved_.size ());
+#endif // __linux__
+}
+
+}
@@ -1,5 +1,6 @@
 #include <bs/fuzzy_choquet.hpp>
 #include <bs/detail/lbp.hpp>
+#include <bs/ewma.hpp>
 #include <bs/utils.hpp>
 
 #include <iostream>
@@ -16,29 +17,52 @@ namespace bs {
 
 /* explicit */
 fuzzy_choquet_t::fuzzy_choquet_t (
-    const cv::Mat& b, double a, double t, const vector< double >& g)
-    : detail::base_t (b), alpha_ (a), threshold_ (t), g_ (g)
+    const cv::Mat& b, double a, double t, const vector< double >& g,
+    const execution_t& x)
+    : detail::base_t (b.clone (), { }, x), alpha_ (a), threshold_ (t), g_ (g),
+      range_ { }, approximate_ { }
 { }
 
+void
+fuzzy_choquet_t::bootstrap (const std::vector< cv::Mat >& frames) {
+    const execution_scope_t scope (execution_);
+
+    BS_ASSERT (!frames.empty ());
+
+    window_mean_t f (0, CV_32F);
+
+    for (const auto& frame : frames) {
+        BS_ASSERT (3 == frame.channels ());
+        f (convert_color (frame, cv::COLOR_BGR2YCrCb));
+    }
+
+    convert (f.value (), CV_32F, 1./255).copyTo (background_);
+}
+
 const cv::Mat&
 fuzzy_choquet_t::operator() (const cv::Mat& frame) {
+    const execution_scope_t scope (execution_);
+
     BS_ASSERT (3 == frame.channels ());
 
-    Mat fframe = convert (
-        convert_color (frame, cv::COLOR_BGR2YCrCb), CV_32F, 1./255);
+    convert_color (frame, color_, cv::COLOR_BGR2YCrCb);
+    convert (color_, frame_, CV_32F, 1./255);
+
+    gray_from (frame_, fg_);
+    gray_from (background_, bg_);
 
-    const auto F = lbp (gray_from (fframe)) / 255.;
-    const auto B = lbp (gray_from (background_)) / 255.;
+    lbp_similarity (fg_, bg_, h_, approximate_);
+    similarity3 (frame_, background_, i_, approximate_);
 
-    const auto H = similarity1 (F, B);
-    const auto I = similarity3 (fframe, background_);
+    choquet_integral (h_, i_, s_, g_);
+    median_blur (s_, t_);
 
-    const auto S = median_blur (choquet_integral (H, I, g_));
+    update_background (frame_, background_, t_, alpha_, range_);
 
-    background_ = update_background (fframe, background_, S, alpha_);
+    threshold (t_, s_, threshold_, 255.f, THRESH_BINARY_INV);
+    convert (s_, mask_, CV_8U, 255.f);
 
-    return mask_ = convert (
-        threshold (S, threshold_, 255.f, THRESH_BINARY_INV), CV_8U, 255.f);
+    return emit_mask ();
 }
 
 }
@@ -2,177 +2,482 @@
 #define BS_FUZZY_INTEGRAL_HPP
 
 #include <bs/defs.hpp>
+#include <bs/cpu.hpp>
+#include <bs/detail/lbp.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
 
 #include <opencv2/imgproc.hpp>
 using namespace cv;
 
 namespace {
 
-inline void
-sort3 (double* f, int* i)
+//
+// The reciprocal, from a bit-level estimate refined by two Newton-Raphson
+// steps, to within 1e-5 relative error for arguments in [2^-125, 2^124]:
+//
+inline float
+approx_reciprocal (float x)
 {
-    static const int arr [][3] = {
-        { 2, 1, 0 },
-        { 1, 2, 0 },
-        { 0, 0, 0 },
-        { 1, 0, 2 },
-        { 2, 0, 1 },
-        { 0, 0, 0 },
-        { 0, 2, 1 },
-        { 0, 1, 2 }
-    };
+    uint32_t i;
+    memcpy (&i, &x, sizeof i);
 
-    const auto& a = f [0];
-    const auto& b = f [1];
-    const auto& c = f [2];
+    i = 0x7EF311C3U - i;
 
-    unsigned mask =
-        (a >= b ? 4 : 0) |
-        (a >= c ? 2 : 0) |
-        (b >= c ? 1 : 0);
+    float y;
+    memcpy (&y, &i, sizeof y);
 
-    const auto& p = arr [mask];
+    y = y * (2.f - x * y);
+    y = y * (2.f - x * y);
 
-    i [0] = p [0];
-    i [1] = p [1];
-    i [2] = p [2];
+    return y;
 }
 
-inline double
-h_texture (double lhs, double rhs, double off = 1./255)
+//
+// The similarity of two values is the ratio of the smaller to the larger one,
+// 1 if they are within the offset of each other:
+//
+template< bool Approximate >
+inline float
+h_texture (float lhs, float rhs, float off = 1.f / 255)
 {
-    return (lhs + off) < rhs ? lhs / rhs : lhs > (rhs + off) ? rhs / lhs : 1;
+    const float lo = (min) (lhs, rhs), hi = (max) (lhs, rhs);
+    const float ratio = Approximate ? lo * approx_reciprocal (hi) : lo / hi;
+
+    return (lo + off) < hi ? ratio : 1.f;
 }
 
-inline Vec3f
-h_texture (const Vec3f& lhs, const Vec3f& rhs, double off = 1./255)
+//
+// The row kernels, compiled per instruction set tier (see BS_CLONES); the
+// tag carries the choice of the reciprocal:
+//
+template< bool Approximate >
+using approximate_t = std::integral_constant< bool, Approximate >;
+
+template< bool Approximate >
+BS_INLINE void
+similarity_row (const float* p, const float* q, float* r, int n,
+                approximate_t< Approximate >)
 {
-    Vec3f result;
+#pragma omp simd
+    for (int j = 0; j < n; ++j)
+        r [j] = h_texture< Approximate > (p [j], q [j]);
+}
 
-#define T(a, b, c) c = h_texture (a, b, off)
+BS_CLONES (similarity_row)
 
-    T (lhs [0], rhs [0], result [0]);
-    T (lhs [1], rhs [1], result [1]);
-    T (lhs [2], rhs [2], result [2]);
+template< bool Approximate >
+inline void
+similarity (const Mat& fg, const Mat& bg, Mat& dst)
+{
+    const int n = fg.cols * fg.channels ();
 
-#undef T
+#pragma omp parallel for
+    for (int i = 0; i < fg.rows; ++i) {
+        similarity_row_dispatch (
+            fg.ptr< float > (i), bg.ptr< float > (i), dst.ptr< float > (i), n,
+            approximate_t< Approximate > ());
+    }
+}
+
+//
+// Per-channel similarity of two CV_32F or CV_32FC3 matrices, in [0, 1]; like
+// the helpers in utils.hpp, the functions below write into a destination that
+// keeps its buffer across frames, or return a new matrix:
+//
+inline void
+similarity (const Mat& fg, const Mat& bg, Mat& d, bool approximate = false)
+{
+    BS_ASSERT (fg.type () == bg.type ());
+    BS_ASSERT (fg.depth () == CV_32F);
 
-    return result;
+    d.create (fg.size (), fg.type ());
+
+    if (approximate)
+        similarity< true > (fg, bg, d);
+    else
+        similarity< false > (fg, bg, d);
 }
 
 inline Mat
-similarity1 (const Mat& fg, const Mat& bg)
+similarity (const Mat& fg, const Mat& bg, bool approximate = false)
 {
-    Mat d = Mat (fg.size (), CV_32F, Scalar (0));
+    Mat d;
+    return similarity (fg, bg, d, approximate), d;
+}
+
+inline Mat
+similarity1 (const Mat& fg, const Mat& bg, bool approximate = false)
+{
+    BS_ASSERT (fg.type () == CV_32F);
+    return similarity (fg, bg, approximate);
+}
+
+inline void
+similarity3 (const Mat& fg, const Mat& bg, Mat& d, bool approximate = false)
+{
+    BS_ASSERT (fg.type () == CV_32FC3);
+    similarity (fg, bg, d, approximate);
+}
+
+inline Mat
+similarity3 (const Mat& fg, const Mat& bg, bool approximate = false)
+{
+    BS_ASSERT (fg.type () == CV_32FC3);
+    return similarity (fg, bg, approximate);
+}
+
+//
+// The rows above, at and below of either image, p and q:
+//
+template< bool Approximate >
+BS_INLINE void
+lbp_similarity_row (const float* const* p, const float* const* q, float* r,
+                    int cols, approximate_t< Approximate >)
+{
+    const float off = 1.f / 255;
+
+#pragma omp simd
+    for (int j = 1; j < cols - 1; ++j) {
+        const float a = bs::detail::lbp_code (
+            p [0] + j - 1, p [1] + j - 1, p [2] + j - 1, off);
 
+        const float b = bs::detail::lbp_code (
+            q [0] + j - 1, q [1] + j - 1, q [2] + j - 1, off);
+
+        //
+        // The codes scaled as those of the LBP images, the offset is one code;
+        // the difference of two adjacent codes rounds either side of it, and
+        // it is compared exactly, as the double comparison of the LBP images
+        // does:
+        //
+        const float x = a * off, y = b * off;
+        const float lo = (min) (x, y), hi = (max) (x, y);
+
+        const float ratio = Approximate
+            ? lo * approx_reciprocal (hi) : lo / hi;
+
+        r [j] = off <= hi - lo ? ratio : 1.f;
+    }
+}
+
+BS_CLONES (lbp_similarity_row)
+
+template< bool Approximate >
+inline void
+lbp_similarity (const Mat& fg, const Mat& bg, Mat& dst)
+{
 #pragma omp parallel for
-    for (size_t i = 0; i < fg.total (); ++i) {
-        d.at< float > (i) = h_texture (fg.at< float > (i), bg.at< float > (i));
+    for (int i = 1; i < fg.rows - 1; ++i) {
+        const float* p [] = {
+            fg.ptr< float > (i - 1), fg.ptr< float > (i), fg.ptr< float > (i + 1)
+        };
+
+        const float* q [] = {
+            bg.ptr< float > (i - 1), bg.ptr< float > (i), bg.ptr< float > (i + 1)
+        };
+
+        lbp_similarity_row_dispatch (
+            p, q, dst.ptr< float > (i), fg.cols, approximate_t< Approximate > ());
     }
+}
 
-    return d;
+//
+// The similarity of the LBP codes of two CV_32F gray images, same as that of
+// the LBP images, without computing them; the border has no code, and is
+// similar:
+//
+inline void
+lbp_similarity (const Mat& fg, const Mat& bg, Mat& d, bool approximate = false)
+{
+    BS_ASSERT (fg.type () == CV_32F);
+    BS_ASSERT (bg.type () == CV_32F);
+
+    d.create (fg.size (), CV_32F);
+
+    d.row (0).setTo (Scalar (1));
+    d.row (d.rows - 1).setTo (Scalar (1));
+    d.col (0).setTo (Scalar (1));
+    d.col (d.cols - 1).setTo (Scalar (1));
+
+    if (approximate)
+        lbp_similarity< true > (fg, bg, d);
+    else
+        lbp_similarity< false > (fg, bg, d);
 }
 
 inline Mat
-similarity3 (const Mat& fg, const Mat& bg)
+lbp_similarity (const Mat& fg, const Mat& bg, bool approximate = false)
 {
-    Mat d = Mat (fg.size (), CV_32FC3, Scalar (0));
+    Mat d;
+    return lbp_similarity (fg, bg, d, approximate), d;
+}
 
-    for (size_t i = 0; i < fg.total (); ++i) {
-        d.at< Vec3f > (i) = h_texture (fg.at< Vec3f > (i), bg.at< Vec3f > (i));
-    }
+//
+// With an additive fuzzy measure the Choquet integral reduces to the weighted
+// sum of the criteria:
+//
+BS_INLINE void
+choquet_row (const float* h, const float* d, float* s, int n,
+             float g0, float g1, float g2)
+{
+#pragma omp simd
+    for (int j = 0; j < n; ++j)
+        s [j] = h [j] * g0 + d [3 * j] * g1 + d [3 * j + 1] * g2;
+}
+
+BS_CLONES (choquet_row)
+
+inline void
+choquet_integral (const Mat& H, const Mat& I, Mat& S, const vector< double >& g)
+{
+    BS_ASSERT (H.type () == CV_32F);
+    BS_ASSERT (I.type () == CV_32FC3);
+    BS_ASSERT (g.size () >= 3);
+
+    const float g0 = g [0], g1 = g [1], g2 = g [2];
+
+    S.create (H.size (), CV_32F);
 
-    return d;
+#pragma omp parallel for
+    for (int i = 0; i < H.rows; ++i) {
+        choquet_row_dispatch (
+            H.ptr< float > (i), I.ptr< float > (i), S.ptr< float > (i), H.cols,
+            g0, g1, g2);
+    }
 }
 
 inline Mat
 choquet_integral (const Mat& H, const Mat& I, const vector< double >& g)
 {
-    Mat S (H.size (), CV_32F);
+    Mat S;
+    return choquet_integral (H, I, S, g), S;
+}
+
+//
+// Same, for n criteria, one CV_32F plane each:
+//
+inline Mat
+choquet_integral (const vector< Mat >& X, const vector< double >& g)
+{
+    BS_ASSERT (!X.empty ());
+    BS_ASSERT (g.size () >= X.size ());
+
+    const int n = X.size ();
+    const vector< float > w (g.begin (), g.begin () + n);
+
+    Mat S (X [0].size (), CV_32F, Scalar (0));
 
 #pragma omp parallel for
-    for (size_t i = 0; i < H.total (); ++i) {
-        const auto h = H.at< float > (i);
-        const auto d = I.at< Vec3f > (i);
+    for (int i = 0; i < S.rows; ++i) {
+        float* s = S.ptr< float > (i);
 
-        S.at< float > (i) = h * g [0] + d [0] * g [1] + d [1] * g [2];
+        for (int k = 0; k < n; ++k) {
+            const float* x = X [k].ptr< float > (i);
+            const float wk = w [k];
+
+#pragma omp simd
+            for (int j = 0; j < S.cols; ++j)
+                s [j] += x [j] * wk;
+        }
     }
 
     return S;
 }
 
+//
+// Certainly, the feature sets is X = {x_1, x_2, x_3 }. One element is x_1 =
+// {texture} and the others are x_2 = { I_1 } and x_3 = { I_2 } [...] Let h_i :
+// X → [0,1] be a fuzzy function. Fuzzy function h_1 = h(x_1) = h_{texture} is
+// the evaluation of texture feature. Fuzzy function h_2 = h(x_2) = h_{ΔI_1} is
+// the evaluation of color feature I_1. Fuzzy function h_3 = h(x_3) = h_{ΔI_2}
+// is the evaluation of color feature I_2.
+//
+// The calculation of the fuzzy integral is as follows: suppose h(x_1) ≥ h(x_2)
+// ≥ h(x_3), if not, X is rearranged so that this relation holds [...] A fuzzy
+// integral, S, with respect to a fuzzy measure g over X can be computed by S =
+// max_{i=1}^n[min(h(x_i), g(X_i))].
+//
+// Instead of sorting, the measure of the set of each criterion is the sum of
+// the densities of the criteria ranked at or after it, ties ranked by index;
+// the set of the first ranked criterion measures 1:
+//
+BS_INLINE void
+sugeno_row (const float* h, const float* d, float* s, int n,
+            float g0, float g1, float g2)
+{
+#pragma omp simd
+    for (int j = 0; j < n; ++j) {
+        const float a = h [j], b = d [3 * j], c = d [3 * j + 1];
+
+        const bool ab = a >= b, ac = a >= c, bc = b >= c;
+
+        const float ga = ab && ac ? 1.f
+            : g0 + (ab ? g1 : 0.f) + (ac ? g2 : 0.f);
+
+        const float gb = !ab && bc ? 1.f
+            : g1 + (ab ? 0.f : g0) + (bc ? g2 : 0.f);
+
+        const float gc = !ac && !bc ? 1.f
+            : g2 + (ac ? 0.f : g0) + (bc ? 0.f : g1);
+
+        s [j] = (max) ((max) ((min) (a, ga), (min) (b, gb)), (min) (c, gc));
+    }
+}
+
+BS_CLONES (sugeno_row)
+
+inline void
+sugeno_integral (const Mat& H, const Mat& I, Mat& S, const vector< double >& g)
+{
+    BS_ASSERT (H.type () == CV_32F);
+    BS_ASSERT (I.type () == CV_32FC3);
+    BS_ASSERT (g.size () >= 3);
+
+    const float g0 = g [0], g1 = g [1], g2 = g [2];
+
+    S.create (H.size (), CV_32F);
+
+#pragma omp parallel for
+    for (int i = 0; i < H.rows; ++i) {
+        sugeno_row_dispatch (
+            H.ptr< float > (i), I.ptr< float > (i), S.ptr< float > (i), H.cols,
+            g0, g1, g2);
+    }
+}
+
 inline Mat
 sugeno_integral (const Mat& H, const Mat& I, const vector< double >& g)
 {
-    double h_x [3], s [3];
+    Mat S;
+    return sugeno_integral (H, I, S, g), S;
+}
 
-    Mat S (H.size (), CV_32F);
+//
+// Same, for n criteria, one CV_32F plane each:
+//
+inline Mat
+sugeno_integral (const vector< Mat >& X, const vector< double >& g)
+{
+    BS_ASSERT (!X.empty ());
+    BS_ASSERT (g.size () >= X.size ());
+
+    const int n = X.size ();
+    const vector< float > w (g.begin (), g.begin () + n);
+
+    Mat S (X [0].size (), CV_32F, Scalar (0));
 
 #pragma omp parallel for
-    for (size_t i = 0; i < H.total (); ++i) {
-        const auto h = H.at< float > (i);
-        const auto d = I.at< Vec3f > (i);
+    for (int i = 0; i < S.rows; ++i) {
+        vector< const float* > x (n);
 
-        //
-        // Certainly, the feature sets is X = {x_1, x_2, x_3 }. One element is
-        // x_1 = {texture} and the others are x_2 = { I_1 } and x_3 = { I_2 }
-        // [...] Let h_i : X → [0,1] be a fuzzy function. Fuzzy function
-        // h_1 = h(x_1) = h_{texture} is the evaluation of texture feature.
-        // Fuzzy function h_2 = h(x_2) = h_{ΔI_1} is the evaluation of color
-        // feature I_1. Fuzzy function h_3 = h(x_3) = h_{ΔI_2} is the
-        // evaluation of color feature I_2.
-        //
-        h_x [0] = h;
-        h_x [1] = d [0];
-        h_x [2] = d [1];
+        for (int k = 0; k < n; ++k)
+            x [k] = X [k].ptr< float > (i);
 
-        int index [3] = { 0, 1, 2 };
+        float* s = S.ptr< float > (i);
 
-        //
-        // The calculation of the fuzzy integral is as follows: suppose
-        // h(x_1) ≥ h(x_2) ≥ h(x_3), if not, X is rearranged so that
-        // this relation holds [...]
-        //
-        sort3 (h_x, index);
+        for (int j = 0; j < S.cols; ++j) {
+            float result = 0;
 
-        //
-        // [...] A fuzzy integral, S, with respect to a fuzzy measure g
-        // over X can be computed by S = max_{i=1}^n[min(h(x_i), g(X_i))]:
-        //
-        s [0] = (min) (h_x [index [0]], 1.);
-        s [1] = (min) (h_x [index [1]], g [index [1]] + g [index [2]]);
-        s [2] = (min) (h_x [index [2]], g [index [2]]);
+            for (int k = 0; k < n; ++k) {
+                const float h = x [k][j];
+
+                float measure = w [k];
+                bool first = true;
+
+                for (int l = 0; l < n; ++l) {
+                    if (l == k)
+                        continue;
+
+                    //
+                    // Criterion l is ranked after k:
+                    //
+                    const bool after = l > k ? h >= x [l][j] : h > x [l][j];
+
+                    measure += after ? w [l] : 0.f;
+                    first = first && after;
+                }
 
-        S.at< float > (i) = max_element (s, s + 3)[0];
+                result = (max) (result, (min) (h, first ? 1.f : measure));
+            }
+
+            s [j] = result;
+        }
     }
 
     return S;
 }
 
-inline Mat
-update_background (const Mat& F, const Mat& B, const Mat& S, float alpha)
+//
+// Blends the frame into the background, in place:
+//
+//   B = β B + (1 - β) (α F + (1 - α) B), β = 1 - max (S - min) / (max - min)
+//
+// i.e., B += α k (S - min) (F - B), k = max / (max - min). The range of S is
+// the one of the previous frame, the range of the current one is accumulated
+// in the same pass, for the next; it is only computed upfront the first time.
+// A similarity out of the previous range would blend by less than 0, away
+// from the frame, or by more than α; the rate is clamped to [0, α]:
+//
+BS_INLINE void
+update_background_row (const float* f, const float* s, float* b, int n,
+                       float k, float min_, float alpha, float& lo_,
+                       float& hi_)
 {
-    Mat result (F.size (), CV_32FC3, Scalar (0));
+    float lo = lo_, hi = hi_;
 
-    double min_, max_;
-    std::tie (min_, max_) = bs::minmax (S);
+#pragma omp simd reduction(min:lo) reduction(max:hi)
+    for (int j = 0; j < n; ++j) {
+        const float t = s [j];
 
-#pragma omp parallel for
-    for (size_t i = 0; i < F.total (); ++i) {
-        auto& dst = result.at< Vec3f > (i);
+        lo = (min) (lo, t);
+        hi = (max) (hi, t);
+
+        const float c = (min) ((max) (k * (t - min_), 0.f), alpha);
+
+        b [3 * j]     += c * (f [3 * j]     - b [3 * j]);
+        b [3 * j + 1] += c * (f [3 * j + 1] - b [3 * j + 1]);
+        b [3 * j + 2] += c * (f [3 * j + 2] - b [3 * j + 2]);
+    }
+
+    lo_ = lo;
+    hi_ = hi;
+}
+
+BS_CLONES (update_background_row)
+
+inline void
+update_background (const Mat& F, Mat& B, const Mat& S, float alpha,
+                   std::pair< double, double >& range)
+{
+    BS_ASSERT (F.type () == CV_32FC3);
+    BS_ASSERT (B.type () == CV_32FC3);
+    BS_ASSERT (S.type () == CV_32F);
+
+    if (range.first >= range.second)
+        range = bs::minmax (S);
+
+    const float min_ = range.first, max_ = range.second;
 
-        const auto& f = F.at< Vec3f > (i);
-        const auto& b = B.at< Vec3f > (i);
-        const auto& s = S.at< float > (i);
+    //
+    // A flat similarity leaves the background unchanged:
+    //
+    const float k = max_ > min_ ? alpha * max_ / (max_ - min_) : 0.f;
 
-        const auto beta = 1. - max_ * (s - min_) / (max_ - min_);
+    float lo = std::numeric_limits< float >::max (), hi = -lo;
 
-        dst [0] = beta * b [0] + (1 - beta) * (alpha * f [0] + (1 - alpha) * b [0]);
-        dst [1] = beta * b [1] + (1 - beta) * (alpha * f [1] + (1 - alpha) * b [1]);
-        dst [2] = beta * b [2] + (1 - beta) * (alpha * f [2] + (1 - alpha) * b [2]);
+#pragma omp parallel for reduction(min:lo) reduction(max:hi)
+    for (int i = 0; i < F.rows; ++i) {
+        update_background_row_dispatch (
+            F.ptr< float > (i), S.ptr< float > (i), B.ptr< float > (i), F.cols,
+            k, min_, alpha, lo, hi);
     }
 
-    return result;
+    range = { lo, hi };
 }
 
 }
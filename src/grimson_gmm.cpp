@@ -1,6 +1,8 @@
 #include <bs/utils.hpp>
+#include <bs/detail/bootstrap.hpp>
 #include <bs/grimson_gmm.hpp>
 
+#include <memory>
 #include <numeric>
 using namespace std;
 
@@ -8,72 +10,132 @@ using namespace std;
 
 namespace bs {
 
-inline grimson_gmm_t::gaussian_t
-grimson_gmm_t::make_gaussian (const cv::Vec3b& src, double v, double s, double a) {
-    return gaussian_t { v, s, a, a / s, cv::Vec3d (src) };
+template< typename T >
+inline typename basic_grimson_gmm_t< T >::gaussian_t
+basic_grimson_gmm_t< T >::make_gaussian (
+    const T& src, double v, double s, double a) {
+    return gaussian_t { v, s, a, a / s, detail::vec_from (src) };
 }
 
-inline grimson_gmm_t::gaussian_t
-grimson_gmm_t::make_gaussian (const cv::Vec3b& src, double v, double a) {
+template< typename T >
+inline typename basic_grimson_gmm_t< T >::gaussian_t
+basic_grimson_gmm_t< T >::make_gaussian (const T& src, double v, double a) {
     return make_gaussian (src, v, sqrt (v), a);
 }
 
-inline grimson_gmm_t::gaussian_t
-grimson_gmm_t::make_gaussian (const cv::Vec3b& src, double v) {
+template< typename T >
+inline typename basic_grimson_gmm_t< T >::gaussian_t
+basic_grimson_gmm_t< T >::make_gaussian (const T& src, double v) {
     return make_gaussian (src, v, sqrt (v), 1.);
 }
 
+template< typename T >
 /* explicit */
-grimson_gmm_t::grimson_gmm_t (
+basic_grimson_gmm_t< T >::basic_grimson_gmm_t (
     size_t n, double alpha, double variance_threshold, double variance,
-    double weight_threshold)
-    : size_ (n),
+    double weight_threshold, const execution_t& x)
+    : detail::base_t ({ }, { }, x),
+      size_ (n),
       alpha_ (alpha),
       variance_threshold_ (variance_threshold),
       variance_ (variance),
-      weight_threshold_ (weight_threshold)
+      weight_threshold_ (weight_threshold),
+      decay_ (alpha)
 { }
 
+template< typename T >
+void
+basic_grimson_gmm_t< T >::allocate (size_t n) {
+    const int node = execution_.node;
+
+    g_ = detail::numa_array_t< gaussian_t > (n * size_, node);
+    counts_ = detail::numa_array_t< unsigned > (n, node);
+    stamps_ = detail::numa_array_t< detail::decay_stamp_t > (n, node);
+}
+
+template< typename T >
 const cv::Mat&
-grimson_gmm_t::operator() (const cv::Mat& frame) {
-    mask_ = cv::Mat (frame.size (), CV_8U, cv::Scalar (255));
+basic_grimson_gmm_t< T >::operator() (const cv::Mat& frame) {
+    const execution_scope_t scope (execution_);
+
+    BS_ASSERT (frame.type () == detail::pixel_traits< T >::type);
+
+    mask_.create (frame.size (), CV_8U);
+    mask_.setTo (cv::Scalar (255));
 
     if (g_.empty ()) {
-        g_.resize (frame.total ());
+        allocate (frame.total ());
+
+        const auto stamp = decay_.stamp ();
 
-        for (size_t i = 0; i < g_.size (); ++i) {
-            auto& g = g_ [i];
-            g.reserve (size_);
+        //
+        // First touch, with the schedule of the update loop, so that each
+        // thread updates the pixels it placed on its own node:
+        //
+#pragma omp parallel for schedule (static)
+        for (size_t i = 0; i < frame.total (); ++i) {
+            const auto g = make_gaussian (frame.at< T > (i), variance_);
 
-            const auto& src = frame.at< cv::Vec3b > (i);
-            g.resize (1UL, make_gaussian (src, variance_));
+            uninitialized_fill_n (g_.data () + i * size_, size_, g);
+
+            counts_ [i] = 1;
+            stamps_ [i] = stamp;
         }
 
         background_ = frame.clone ();
     }
     else {
-#pragma omp parallel for
+        decay_.advance ();
+
+#pragma omp parallel for schedule (static)
         for (size_t i = 0; i < frame.total (); ++i) {
-            const auto& src = frame.at< cv::Vec3b > (i);
+            const auto& src = frame.at< T > (i);
+            const auto x = detail::vec_from (src);
+
+            gaussian_t* const gs = g_.data () + i * size_;
+            auto& count = counts_ [i];
+
+            auto& stamp = stamps_ [i];
+
+            {
+                //
+                // Bring the weights into the current epoch:
+                //
+                const double factor = decay_.rebase (stamp);
+
+                if (1. != factor) {
+                    for_each (gs, gs + count, [=](auto& g) {
+                            g.w *= factor; });
 
-            auto& gs = g_ [i];
+                    stamp.total = accumulate (
+                        gs, gs + count, 0., [](auto accum, const auto& g) {
+                            return accum + g.w; });
+                }
+            }
 
-            for_each (begin (gs), end (gs), [=](auto& g) {
+            for_each (gs, gs + count, [=](auto& g) {
                     g.g = g.w / g.s; });
 
-            sort (begin (gs), end (gs), [](const auto& g1, const auto& g2) {
+            sort (gs, gs + count, [](const auto& g1, const auto& g2) {
                     return g1.g > g2.g; });
 
             size_t n = 0;
 
+            //
+            // The weights are not normalized, scale the threshold instead:
+            //
+            const double weight_threshold = weight_threshold_ * stamp.total;
+
             for (double sum = 0.;
-                 n < gs.size () && sum < weight_threshold_; ++n) {
+                 n < count && sum < weight_threshold; ++n) {
                 sum += gs [n].w;
             }
 
-            int once = 0;
+            const double increment = decay_.increment (stamp);
 
-            for (size_t j = 0; j < gs.size (); ++j) {
+            size_t j = 0;
+
+            for (; j < count; ++j) {
                 auto& g = gs [j];
 
                 auto& v = g.v;
@@ -81,63 +143,131 @@ grimson_gmm_t::operator() (const cv::Mat& frame) {
                 auto& w = g.w;
                 auto& m = g.m;
 
-                const auto distance = sqrt (dot (cv::Vec3d (src) - m));
+                const auto distance = sqrt (dot (x - m));
 
-                if (!once && distance < variance_threshold_ * s && ++once) {
+                if (distance < variance_threshold_ * s) {
                     if (j < n) {
                         //
                         // If the distance is close enough to a distribution
                         // that models the background:
                         //
                         mask_.at< unsigned char > (i) = 0;
-                        background_.at< cv::Vec3b > (i) = gs [0].m;
                     }
 
-                    const double r = alpha_ * w;
+                    const double r = alpha_ * w / stamp.total;
 
-                    w = (1. - alpha_) * w + alpha_;
+                    w += increment;
 
-                    m [0] += r * (src [0] - m [0]);
-                    m [1] += r * (src [1] - m [1]);
-                    m [2] += r * (src [2] - m [2]);
+                    m += r * (x - m);
 
                     v += r * (distance - v);
                     s = sqrt (v);
-                }
-                else {
+
                     //
-                    // All other distributions are unchanged:
+                    // All other distributions are unchanged, their decay is
+                    // accounted for in the sum of the weights:
                     //
-                    w = (1. - alpha_) * w;
+                    break;
                 }
             }
 
-            if (!once) {
+            if (j == count) {
                 //
                 // No matching will create a new distribution or replace the
                 // weakest (least probable):
                 //
-                if (gs.size () < size_) {
-                    gs.emplace_back (make_gaussian (src, variance_, alpha_));
+                if (count < size_) {
+                    gs [count++] = make_gaussian (src, variance_, increment);
                 }
                 else {
-                    gs.emplace_back (make_gaussian (src, variance_, alpha_));
+                    stamp.total -= gs [count - 1].w;
+                    gs [count - 1] = make_gaussian (src, variance_, increment);
                 }
             }
 
             //
-            // Re-normalize the weights:
+            // The re-normalization of the weights is deferred, only the sum is
+            // updated:
             //
-            const auto normal = 1. / accumulate (
-                begin (gs), end (gs), 0., [](auto accum, const auto& g) {
-                    return accum + g.w;
-                });
+            stamp.total += increment;
+        }
+
+        invalidate_background ();
+    }
+
+    return emit_mask ();
+}
+
+template< typename T >
+void
+basic_grimson_gmm_t< T >::bootstrap (const std::vector< cv::Mat >& frames) {
+    const execution_scope_t scope (execution_);
+
+    BS_ASSERT (!frames.empty ());
+
+    const auto& frame = frames.front ();
+
+    for (const auto& x : frames) {
+        BS_ASSERT (x.type () == detail::pixel_traits< T >::type);
+        BS_ASSERT (x.size () == frame.size ());
+    }
+
+    allocate (frame.total ());
+
+    const auto stamp = decay_.stamp ();
+
+    const double d = variance_threshold_ * variance_threshold_ * variance_;
+    const double n = frames.size ();
+
+#pragma omp parallel
+    {
+        std::vector< detail::batch_mode_t< T > > modes;
+
+#pragma omp for schedule (static)
+        for (size_t i = 0; i < frame.total (); ++i) {
+            detail::cluster_batch (frames, i, size_, d, modes);
+
+            gaussian_t* gs = g_.data () + i * size_;
+
+            double total = 0.;
+
+            for (const auto& mode : modes) {
+                const double v = mode.variance (variance_), w = mode.n / n;
+                const double s = sqrt (v);
+
+                *gs++ = gaussian_t { v, s, w, w / s, mode.m };
+
+                total += w;
+            }
 
-            for_each (begin (gs), end (gs), [=](auto& g) { g.w *= normal; });
+            counts_ [i] = unsigned (modes.size ());
+
+            stamps_ [i] = stamp;
+            stamps_ [i].total = total;
         }
     }
 
-    return mask_;
+    background_.create (frame.size (), frame.type ());
+    mask_ = cv::Mat (frame.size (), CV_8U, cv::Scalar (0));
+
+    invalidate_background ();
+}
+
+template< typename T >
+void
+basic_grimson_gmm_t< T >::materialize () const {
+    //
+    // The mean of the most probable mode of each pixel:
+    //
+#pragma omp parallel for schedule (static)
+    for (size_t i = 0; i < counts_.size (); ++i) {
+        if (counts_ [i])
+            background_.at< T > (i) = detail::pixel_from< T > (g_ [i * size_].m);
+    }
 }
 
+template struct basic_grimson_gmm_t< unsigned char >;
+template struct basic_grimson_gmm_t< unsigned short >;
+template struct basic_grimson_gmm_t< cv::Vec3b >;
+
 }
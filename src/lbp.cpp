@@ -1,3 +1,4 @@
+#include <bs/cpu.hpp>
 #include <bs/utils.hpp>
 #include <bs/detail/lbp.hpp>
 
@@ -5,6 +6,20 @@
 
 namespace {
 
+//
+// The codes of the inner pixels of a row, from the rows above, at and below:
+//
+template< typename T >
+BS_INLINE void
+lbp_row (const T* p, const T* q, const T* r, T* s, int cols, T off) {
+    ++s;
+
+    for (int j = 1; j < cols - 1; ++j, ++p, ++q, ++r, ++s)
+        s [0] = bs::detail::lbp_code (p, q, r, off);
+}
+
+BS_CLONES (lbp_row)
+
 template< typename T >
 inline cv::Mat
 do_lbp (const cv::Mat& src, T off = { }) {
@@ -12,28 +27,9 @@ do_lbp (const cv::Mat& src, T off = { }) {
 
 #pragma omp parallel for
     for (int i = 1; i < src.rows - 1; ++i) {
-        const T* p = src.ptr< T > (i - 1);
-        const T* q = src.ptr< T > (i);
-        const T* r = src.ptr< T > (i + 1);
-
-        T* s = dst.ptr< T > (i);
-        ++s;
-
-        for (int j = 1; j < src.cols - 1; ++j, ++p, ++q, ++r, ++s) {
-            T t = q [1] + off;
-
-            unsigned u =
-                ((p [0] >= t) << 7) +
-                ((p [1] >= t) << 6) +
-                ((p [2] >= t) << 5) +
-                ((q [0] >= t)) +
-                ((q [2] >= t) << 4) +
-                ((r [0] >= t) << 1) +
-                ((r [1] >= t) << 2) +
-                ((r [2] >= t) << 3);
-
-            s [0] = u;
-        }
+        lbp_row_dispatch (
+            src.ptr< T > (i - 1), src.ptr< T > (i), src.ptr< T > (i + 1),
+            dst.ptr< T > (i), src.cols, off);
     }
 
     return dst;
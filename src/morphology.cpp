@@ -0,0 +1,378 @@
+#include <bs/morphology.hpp>
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#if defined (_OPENMP)
+#  include <omp.h>
+#endif // _OPENMP
+
+namespace bs {
+
+namespace {
+
+//
+// The valid bits of the last word of a row:
+//
+inline uint64_t
+tail_of (int cols) {
+    return cols % 64 ? (1ULL << (cols % 64)) - 1 : ~0ULL;
+}
+
+inline uint64_t
+reverse (uint64_t x) {
+    x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+    x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+
+    return __builtin_bswap64 (x);
+}
+
+//
+// Applies a 3x3 filter, separable in a vertical and a horizontal reduction of
+// words, to the rows; the pixels outside the mask read as the fill bit:
+//
+template< typename V, typename H >
+inline void
+filter3 (const packed_mask_t& src, packed_mask_t& dst, uint64_t fill,
+         V vertical, H horizontal) {
+    BS_ASSERT (&src != &dst);
+
+    dst.create (src.rows, src.cols);
+
+    const size_t n = src.stride;
+
+    if (0 == n)
+        return;
+
+    const uint64_t tail = tail_of (src.cols);
+    const vector< uint64_t > outside (n, fill);
+
+#pragma omp parallel for
+    for (int i = 0; i < src.rows; ++i) {
+        const uint64_t* p = i ? src.row (i - 1) : outside.data ();
+        const uint64_t* q = src.row (i);
+        const uint64_t* r = i + 1 < src.rows ? src.row (i + 1) : outside.data ();
+
+        auto at = [&](size_t k) {
+            if (k >= n)
+                return fill;
+
+            const uint64_t x = vertical (p [k], q [k], r [k]);
+            return k + 1 == n ? x | (fill & ~tail) : x;
+        };
+
+        uint64_t* d = dst.row (i);
+
+        for (uint64_t prev = fill, cur = at (0), k = 0; k < n; ++k) {
+            const uint64_t next = at (k + 1);
+
+            //
+            // The left and the right neighbors of the pixels of the word:
+            //
+            const uint64_t lhs = (cur << 1) | (prev >> 63);
+            const uint64_t rhs = (cur >> 1) | (next << 63);
+
+            d [k] = horizontal (lhs, cur, rhs);
+
+            prev = cur;
+            cur = next;
+        }
+
+        d [n - 1] &= tail;
+    }
+}
+
+//
+// Extends the seeds in x along the runs of m they are in, over a row of n
+// words; the carry of an addition runs up a run from its lowest seed, the run
+// is then swept down in reverse:
+//
+inline void
+fill_row (uint64_t* x, const uint64_t* m, size_t n) {
+    auto up = [](uint64_t s, uint64_t m) {
+        return (((m + s) ^ m ^ s) & m) | s;
+    };
+
+    for (uint64_t carry = 0, k = 0; k < n; ++k) {
+        x [k] = up (x [k] | (carry & m [k]), m [k]);
+        carry = x [k] >> 63;
+    }
+
+    for (uint64_t carry = 0, k = n; k-- > 0; ) {
+        const uint64_t y = up (
+            reverse (x [k]) | (carry & reverse (m [k])), reverse (m [k]));
+
+        x [k] = reverse (y);
+        carry = y >> 63;
+    }
+}
+
+//
+// Adds the pixels of the mask row m connected to the reached pixels of the
+// adjacent row y to the row x, and extends them along m; returns whether the
+// row changed:
+//
+inline bool
+propagate (uint64_t* x, const uint64_t* y, const uint64_t* m, size_t n,
+           bool diagonal) {
+    bool changed = false;
+
+    for (size_t k = 0; k < n; ++k) {
+        uint64_t z = y [k];
+
+        if (diagonal) {
+            z |= (y [k] << 1) | (k ? y [k - 1] >> 63 : 0);
+            z |= (y [k] >> 1) | (k + 1 < n ? y [k + 1] << 63 : 0);
+        }
+
+        z &= m [k];
+
+        if (z & ~x [k]) {
+            x [k] |= z;
+            changed = true;
+        }
+    }
+
+    if (changed)
+        fill_row (x, m, n);
+
+    return changed;
+}
+
+}
+
+void
+erode (const packed_mask_t& src, packed_mask_t& dst) {
+    filter3 (
+        src, dst, ~0ULL,
+        [](uint64_t a, uint64_t b, uint64_t c) { return a & b & c; },
+        [](uint64_t a, uint64_t b, uint64_t c) { return a & b & c; });
+}
+
+void
+dilate (const packed_mask_t& src, packed_mask_t& dst) {
+    filter3 (
+        src, dst, 0,
+        [](uint64_t a, uint64_t b, uint64_t c) { return a | b | c; },
+        [](uint64_t a, uint64_t b, uint64_t c) { return a | b | c; });
+}
+
+void
+majority (const packed_mask_t& src, packed_mask_t& dst) {
+    BS_ASSERT (&src != &dst);
+
+    dst.create (src.rows, src.cols);
+
+    const size_t n = src.stride;
+
+    if (0 == n)
+        return;
+
+    const uint64_t tail = tail_of (src.cols);
+    const vector< uint64_t > outside (n, 0);
+
+    //
+    // Bit-sliced counting of the 9 pixels of the windows of 64 pixels, with a
+    // tree of full adders:
+    //
+    auto add = [](uint64_t a, uint64_t b, uint64_t c, uint64_t& carry) {
+        carry = (a & b) | (c & (a ^ b));
+        return a ^ b ^ c;
+    };
+
+#pragma omp parallel for
+    for (int i = 0; i < src.rows; ++i) {
+        const uint64_t* rows [] = {
+            i ? src.row (i - 1) : outside.data (),
+            src.row (i),
+            i + 1 < src.rows ? src.row (i + 1) : outside.data ()
+        };
+
+        uint64_t* d = dst.row (i);
+
+        for (size_t k = 0; k < n; ++k) {
+            uint64_t s [3], c [3];
+
+            for (int j = 0; j < 3; ++j) {
+                const uint64_t* p = rows [j];
+
+                const uint64_t lhs = (p [k] << 1) | (k ? p [k - 1] >> 63 : 0);
+                const uint64_t rhs = (p [k] >> 1) | (
+                    k + 1 < n ? p [k + 1] << 63 : 0);
+
+                s [j] = add (lhs, p [k], rhs, c [j]);
+            }
+
+            uint64_t c1, c2, c4;
+
+            const uint64_t b0 = add (s [0], s [1], s [2], c1);
+            const uint64_t t2 = add (c [0], c [1], c [2], c2);
+
+            const uint64_t b1 = t2 ^ c1;
+            c4 = t2 & c1;
+
+            const uint64_t b2 = c2 ^ c4;
+            const uint64_t b3 = c2 & c4;
+
+            //
+            // At least 5 = 0101:
+            //
+            d [k] = b3 | (b2 & (b1 | b0));
+        }
+
+        d [n - 1] &= tail;
+    }
+}
+
+void
+reconstruct (const packed_mask_t& seeds, const packed_mask_t& mask,
+             packed_mask_t& dst, int connectivity) {
+    BS_ASSERT (seeds.rows == mask.rows && seeds.cols == mask.cols);
+    BS_ASSERT (4 == connectivity || 8 == connectivity);
+
+    dst.create (mask.rows, mask.cols);
+
+    const size_t n = mask.stride;
+    const bool diagonal = 8 == connectivity;
+
+#pragma omp parallel for
+    for (int i = 0; i < mask.rows; ++i) {
+        const uint64_t* p = seeds.row (i);
+        const uint64_t* m = mask.row (i);
+
+        uint64_t* x = dst.row (i);
+
+        for (size_t k = 0; k < n; ++k)
+            x [k] = p [k] & m [k];
+
+        fill_row (x, m, n);
+    }
+
+    //
+    // Alternate downward and upward sweeps over the rows [first, last), until
+    // neither reaches further:
+    //
+    auto sweep = [&](int first, int last) {
+        for (bool changed = true; changed; ) {
+            changed = false;
+
+            for (int i = first + 1; i < last; ++i)
+                changed |= propagate (
+                    dst.row (i), dst.row (i - 1), mask.row (i), n, diagonal);
+
+            for (int i = last - 1; i-- > first; )
+                changed |= propagate (
+                    dst.row (i), dst.row (i + 1), mask.row (i), n, diagonal);
+        }
+    };
+
+    //
+    // Band b covers rows [rows * b / bands, rows * (b + 1) / bands), one per
+    // thread, of at least a few rows:
+    //
+    int bands = 1;
+
+#if defined (_OPENMP)
+    bands = (std::max) ((std::min) (omp_get_max_threads (), mask.rows / 16), 1);
+#endif // _OPENMP
+
+    auto first_of = [&](int b) {
+        return int (size_t (mask.rows) * b / bands);
+    };
+
+    //
+    // The bands settle independently; the merge pass then carries the pixels
+    // across the seams between the bands, both ways, and only the bands it
+    // reached into settle again. The image is settled when no seam changes:
+    //
+    vector< char > dirty (bands, 1);
+
+    for (bool changed = true; changed; ) {
+#pragma omp parallel for if (bands > 1)
+        for (int b = 0; b < bands; ++b) {
+            if (dirty [b])
+                sweep (first_of (b), first_of (b + 1));
+        }
+
+        fill (dirty.begin (), dirty.end (), 0);
+        changed = false;
+
+        for (int b = 1; b < bands; ++b) {
+            const int i = first_of (b);
+
+            if (propagate (
+                    dst.row (i), dst.row (i - 1), mask.row (i), n, diagonal))
+                dirty [b] = changed = true;
+
+            if (propagate (
+                    dst.row (i - 1), dst.row (i), mask.row (i - 1), n,
+                    diagonal))
+                dirty [b - 1] = changed = true;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+morphology_t::morphology_t (std::initializer_list< op_t > ops)
+    : result_ (&buf_ [0]) {
+    //
+    // Openings and closings are chains of the primitive operations:
+    //
+    for (auto op : ops) {
+        switch (op) {
+        case OPEN:
+            ops_.push_back (ERODE);
+            ops_.push_back (DILATE);
+            break;
+
+        case CLOSE:
+            ops_.push_back (DILATE);
+            ops_.push_back (ERODE);
+            break;
+
+        default:
+            ops_.push_back (op);
+            break;
+        }
+    }
+}
+
+const packed_mask_t&
+morphology_t::operator() (const packed_mask_t& src) {
+    const packed_mask_t* p = &src;
+
+    if (ops_.empty ())
+        buf_ [0] = src;
+
+    for (size_t i = 0; i < ops_.size (); ++i) {
+        auto& dst = buf_ [i % 2];
+
+        switch (ops_ [i]) {
+        case ERODE:    erode    (*p, dst); break;
+        case DILATE:   dilate   (*p, dst); break;
+        case MAJORITY: majority (*p, dst); break;
+
+        default:
+            BS_ASSERT (0);
+        }
+
+        p = &dst;
+    }
+
+    result_ = ops_.empty () ? &buf_ [0] : p;
+
+    return *result_;
+}
+
+const cv::Mat&
+morphology_t::operator() (const cv::Mat& src) {
+    pack (src, src_);
+    unpack ((*this) (src_), mask_);
+
+    return mask_;
+}
+
+}
@@ -0,0 +1,78 @@
+#include <bs/detail/numa.hpp>
+
+#include <new>
+
+#if defined (__linux__)
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#else
+#  include <cstdlib>
+#endif // __linux__
+
+namespace bs {
+namespace detail {
+
+#if defined (__linux__)
+
+namespace {
+
+//
+// From linux/mempolicy.h:
+//
+constexpr int mpol_preferred = 1;
+
+}
+
+void*
+numa_allocate (size_t size, int node) {
+    //
+    // Anonymous mappings are backed by pages on first write only:
+    //
+    void* p = mmap (
+        0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (MAP_FAILED == p)
+        throw std::bad_alloc ();
+
+    if (0 <= node && node < 64) {
+        //
+        // Best effort: the pages prefer the node and land on another one when
+        // it is out of memory; if the policy is refused, e.g. for a node that
+        // is not online, they fall back to first touch. The kernel reads one
+        // bit less than maxnode, the width of the mask plus one:
+        //
+        unsigned long mask = 1UL << node;
+        syscall (SYS_mbind, p, size, mpol_preferred, &mask, 65UL, 0U);
+    }
+
+    return p;
+}
+
+void
+numa_deallocate (void* p, size_t size) {
+    munmap (p, size);
+}
+
+#else
+
+void*
+numa_allocate (size_t size, int) {
+    const size_t page = 4096;
+
+    void* p = std::aligned_alloc (page, (size + page - 1) / page * page);
+
+    if (0 == p)
+        throw std::bad_alloc ();
+
+    return p;
+}
+
+void
+numa_deallocate (void* p, size_t) {
+    std::free (p);
+}
+
+#endif // __linux__
+
+}}
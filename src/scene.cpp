@@ -0,0 +1,334 @@
+#include <bs/cpu.hpp>
+#include <bs/scene.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+using namespace std;
+
+#include <opencv2/core.hpp>
+
+namespace {
+
+//
+// The splitmix64 finalizer, for random numbers that depend only on the seed
+// and on where they are used (the frame, the row, the region):
+//
+inline uint64_t
+mix (uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+struct random_t {
+    uint64_t state;
+
+    uint64_t
+    operator() () {
+        return mix (state++);
+    }
+
+    int
+    uniform (int a, int b) {
+        return a + int ((*this) () % uint64_t (b - a + 1));
+    }
+};
+
+//
+// The source coordinate of the samples of a magnification from m to n, pixel
+// centers aligned, as an index and an 8-bit weight of the next sample:
+//
+struct tap_t {
+    int index, weight;
+};
+
+vector< tap_t >
+make_taps (int m, int n) {
+    vector< tap_t > taps (n);
+
+    for (int i = 0; i < n; ++i) {
+        const double x = max ((i + .5) * m / n - .5, 0.);
+        const int k = min (int (x), m - 2);
+
+        taps [i] = { k, min (int (lround ((x - k) * 256)), 256) };
+    }
+
+    return taps;
+}
+
+//
+// A smooth texture, the bilinear magnification of a grid of random values one
+// cell apart, with a fine grain over it; the magnification is done here, in
+// fixed point, so that the scenes do not depend on the OpenCV build:
+//
+cv::Mat
+make_texture (cv::Size size, int type, random_t& random, int cell,
+              int lo, int hi) {
+    const int cn = CV_MAT_CN (type);
+
+    cv::Mat grid (size.height / cell + 2, size.width / cell + 2, type);
+
+    for (int i = 0; i < grid.rows; ++i) {
+        auto p = grid.ptr (i);
+
+        for (int j = 0; j < grid.cols * cn; ++j)
+            p [j] = (unsigned char)random.uniform (lo, hi);
+    }
+
+    const auto xs = make_taps (grid.cols, size.width);
+    const auto ys = make_taps (grid.rows, size.height);
+
+    cv::Mat texture (size, type);
+
+    for (int i = 0; i < texture.rows; ++i) {
+        const auto& y = ys [i];
+
+        auto p = grid.ptr (y.index), q = grid.ptr (y.index + 1);
+        auto r = texture.ptr (i);
+
+        for (int j = 0; j < texture.cols; ++j) {
+            const auto& x = xs [j];
+
+            for (int c = 0; c < cn; ++c) {
+                const int a = x.index * cn + c, b = a + cn;
+
+                const int u = p [a] * (256 - x.weight) + p [b] * x.weight;
+                const int v = q [a] * (256 - x.weight) + q [b] * x.weight;
+
+                const int z = (u * (256 - y.weight) + v * y.weight + 32768) >> 16;
+
+                r [j * cn + c] = cv::saturate_cast< unsigned char > (
+                    z + random.uniform (-12, 12));
+            }
+        }
+    }
+
+    return texture;
+}
+
+//
+// The position of a point bouncing between 0 and n:
+//
+inline int
+reflect (long x, int n) {
+    if (n <= 0)
+        return 0;
+
+    const long p = 2L * n;
+
+    if ((x %= p) < 0)
+        x += p;
+
+    return int (x <= n ? x : p - x);
+}
+
+//
+// A span of a row under the illumination gain (1.7 fixed point, at most 255,
+// so that the products fit in 16 bits) and the noise:
+//
+BS_INLINE void
+shade_row (const unsigned char* src, const signed char* noise,
+           unsigned char* dst, int n, unsigned gain) {
+#pragma omp simd
+    for (int j = 0; j < n; ++j) {
+        const int x = ((unsigned short)(src [j] * gain) >> 7) + noise [j];
+        dst [j] = (unsigned char)(x < 0 ? 0 : x > 255 ? 255 : x);
+    }
+}
+
+BS_CLONES (shade_row)
+
+//
+// The flickering regions hold a texture for this many frames at least; the
+// waves are this many pixels high, this many rows long and this many frames
+// in period:
+//
+const size_t flicker_hold = 4;
+const double wave_amplitude = 3., wave_length = 16., wave_period = 25.;
+
+const double pi = 3.14159265358979323846;
+
+}
+
+namespace bs {
+
+scene_t::scene_t (const scene_options_t& options)
+    : options_ (options) {
+    const cv::Size size = options_.size;
+
+    BS_ASSERT (options_.type == CV_8UC1 || options_.type == CV_8UC3);
+    BS_ASSERT (size.width >= 16 && size.height >= 16);
+    BS_ASSERT (options_.drift >= 0 && options_.drift < 1);
+    BS_ASSERT (options_.period > 0);
+    BS_ASSERT (options_.noise >= 0 && options_.noise < 128);
+
+    const int cn = CV_MAT_CN (options_.type);
+
+    random_t random { options_.seed };
+
+    background_ = make_texture (size, options_.type, random, 16, 48, 208);
+
+    if (options_.flicker)
+        alternate_ = make_texture (size, options_.type, random, 8, 48, 208);
+
+    //
+    // The rows draw their noise from random offsets in the table:
+    //
+    noise_.resize (size_t (size.width) * cn + 65536);
+
+    for (auto& x : noise_)
+        x = (signed char)random.uniform (-options_.noise, options_.noise);
+
+    const int side = (min) (size.width, size.height);
+
+    for (size_t k = 0; k < options_.sprites; ++k) {
+        const cv::Size extent (
+            random.uniform (side / 8, side / 4),
+            random.uniform (side / 8, side / 4));
+
+        sprite_t sprite;
+
+        sprite.texture = make_texture (extent, options_.type, random, 4, 0, 255);
+
+        sprite.origin = cv::Point (
+            random.uniform (0, size.width - extent.width),
+            random.uniform (0, size.height - extent.height));
+
+        sprite.velocity = cv::Point (
+            random.uniform (1, 3) * (random () & 1 ? 1 : -1),
+            random.uniform (1, 3) * (random () & 1 ? 1 : -1));
+
+        sprites_.push_back (sprite);
+    }
+
+    for (size_t k = 0; k < options_.flicker + options_.waving; ++k) {
+        const cv::Size extent (
+            random.uniform (size.width / 8, size.width / 4),
+            random.uniform (size.height / 8, size.height / 4));
+
+        const cv::Point origin (
+            random.uniform (0, size.width - extent.width),
+            random.uniform (0, size.height - extent.height));
+
+        regions_.push_back ({
+                k < options_.flicker ? region_t::FLICKER : region_t::WAVING,
+                cv::Rect (origin, extent) });
+    }
+}
+
+void
+scene_t::render (size_t t, cv::Mat& frame, cv::Mat& mask) const {
+    const cv::Size size = options_.size;
+    const int cn = CV_MAT_CN (options_.type);
+
+    frame.create (size, options_.type);
+    mask.create (size, CV_8U);
+
+    const unsigned gain = unsigned (lround (128. * (1. + options_.drift * sin (
+        2 * pi * double (t % options_.period) / options_.period))));
+
+    vector< cv::Rect > rects;
+
+    for (const auto& sprite : sprites_) {
+        const auto& texture = sprite.texture;
+
+        rects.emplace_back (
+            reflect (sprite.origin.x + long (sprite.velocity.x) * long (t),
+                     size.width - texture.cols),
+            reflect (sprite.origin.y + long (sprite.velocity.y) * long (t),
+                     size.height - texture.rows),
+            texture.cols, texture.rows);
+    }
+
+    vector< int > on (regions_.size ());
+
+    for (size_t k = 0; k < regions_.size (); ++k)
+        on [k] = 1 & mix (
+            (uint64_t (options_.seed) << 32) ^ (uint64_t (k) << 48) ^
+            (t / flicker_hold));
+
+    const size_t offsets = noise_.size () - size_t (size.width) * cn + 1;
+
+#pragma omp parallel for schedule (static)
+    for (int i = 0; i < size.height; ++i) {
+        const signed char* noise = noise_.data () + mix (
+            (uint64_t (options_.seed) << 40) ^ (uint64_t (t) << 20) ^
+            uint64_t (i)) % offsets;
+
+        auto dst = frame.ptr (i);
+        auto m = mask.ptr (i);
+
+        shade_row_dispatch (background_.ptr (i), noise, dst, size.width * cn, gain);
+        memset (m, 0, size.width);
+
+        for (size_t k = 0; k < regions_.size (); ++k) {
+            const auto& r = regions_ [k].rect;
+
+            if (i < r.y || i >= r.y + r.height)
+                continue;
+
+            const int j = r.x * cn, n = r.width * cn;
+
+            if (region_t::FLICKER == regions_ [k].kind) {
+                if (on [k])
+                    shade_row_dispatch (
+                        alternate_.ptr (i) + j, noise + j, dst + j, n, gain);
+            }
+            else {
+                //
+                // The texture of the region, shifted along the row by a wave
+                // that travels down the rows:
+                //
+                const int shift = int (lround (wave_amplitude * sin (
+                    2 * pi * (t / wave_period + (i - r.y) / wave_length))));
+
+                const int x = (min) ((max) (r.x + shift, 0), size.width - r.width);
+
+                shade_row_dispatch (
+                    background_.ptr (i) + x * cn, noise + j, dst + j, n, gain);
+            }
+        }
+
+        for (size_t k = 0; k < rects.size (); ++k) {
+            const auto& r = rects [k];
+
+            if (i < r.y || i >= r.y + r.height)
+                continue;
+
+            const int j = r.x * cn;
+
+            shade_row_dispatch (
+                sprites_ [k].texture.ptr (i - r.y), noise + j, dst + j,
+                r.width * cn, gain);
+
+            memset (m + r.x, 255, r.width);
+        }
+    }
+}
+
+bool
+scene_t::next (cv::Mat& frame, cv::Mat& mask) {
+    if (options_.frames && index_ >= options_.frames)
+        return false;
+
+    render (index_++, frame, mask);
+    return true;
+}
+
+vector< cv::Mat >
+scene_t::frames (size_t n) const {
+    vector< cv::Mat > xs (n);
+
+    cv::Mat mask;
+
+    for (size_t t = 0; t < n; ++t)
+        render (t, xs [t], mask);
+
+    return xs;
+}
+
+}
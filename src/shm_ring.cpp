@@ -0,0 +1,546 @@
+#include <bs/shm_ring.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+using namespace std;
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace bs {
+namespace detail {
+
+constexpr uint32_t shm_magic = 0x62737267; // "bsrg"
+constexpr size_t shm_align = 64;
+
+//
+// The longest a side sleeps before it checks that the other one is alive:
+//
+constexpr long shm_poll_ns = 100 * 1000 * 1000;
+
+static_assert (
+    atomic< uint32_t >::is_always_lock_free,
+    "futex words must be lock-free");
+
+//
+// A process, by its id and its start time, which tells it from a later
+// process that reuses the id:
+//
+struct shm_process_t {
+    atomic< int32_t > pid;
+    atomic< uint64_t > start;
+};
+
+struct shm_header_t {
+    uint32_t magic;
+    uint32_t slots;
+    uint64_t capacity;
+
+    //
+    // The processes of the writer, to tell a segment it left behind, and of
+    // the reader, 0 until one attaches and -1 after it detaches:
+    //
+    shm_process_t writer, reader;
+
+    //
+    // Frames published by the writer and released by the reader; the ring
+    // holds head - tail frames:
+    //
+    alignas (shm_align) atomic< uint32_t > head;
+    alignas (shm_align) atomic< uint32_t > tail;
+
+    atomic< uint32_t > closed;
+
+    //
+    // The futex words each side sleeps on, bumped by the other side after a
+    // frame is published (or the stream closed) and released, respectively:
+    //
+    atomic< uint32_t > reader_event, writer_event;
+    atomic< uint32_t > reader_waiting, writer_waiting;
+};
+
+struct shm_slot_t {
+    int32_t rows, cols, type;
+    uint64_t step;
+};
+
+namespace {
+
+inline size_t
+align (size_t n) {
+    return (n + shm_align - 1) / shm_align * shm_align;
+}
+
+inline size_t
+slot_size (size_t capacity) {
+    return align (sizeof (shm_slot_t)) + align (capacity);
+}
+
+inline size_t
+segment_size (size_t slots, size_t capacity) {
+    return align (sizeof (shm_header_t)) + slots * slot_size (capacity);
+}
+
+[[noreturn]] inline void
+throw_errno (const char* what) {
+    throw system_error (errno, generic_category (), what);
+}
+
+inline void
+futex_wait (atomic< uint32_t >& word, uint32_t value) {
+    const timespec timeout { 0, shm_poll_ns };
+
+    syscall (SYS_futex, reinterpret_cast< uint32_t* > (&word),
+             FUTEX_WAIT, value, &timeout, nullptr, 0);
+}
+
+inline void
+futex_wake (atomic< uint32_t >& word) {
+    syscall (SYS_futex, reinterpret_cast< uint32_t* > (&word),
+             FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+//
+// Sleeps until the other side notifies the event, unless ready, or for a poll
+// period at most: the event is read before the test, and bumped by the other
+// side after it changes what the test reads, so that the kernel refuses the
+// sleep if the notice falls in between. The callers test again on return, and
+// check that the other side is still there:
+//
+template< typename F >
+inline void
+wait_for (atomic< uint32_t >& event, atomic< uint32_t >& waiting, F ready) {
+    const uint32_t value = event;
+
+    ++waiting;
+
+    if (!ready ())
+        futex_wait (event, value);
+
+    --waiting;
+}
+
+inline void
+notify (atomic< uint32_t >& event, atomic< uint32_t >& waiting) {
+    ++event;
+
+    if (waiting)
+        futex_wake (event);
+}
+
+//
+// The state and the start time, in clock ticks since boot, of a process, from
+// /proc; 0 if there is no such process:
+//
+char
+process_state (pid_t pid, uint64_t& start) {
+    char path [32];
+    snprintf (path, sizeof path, "/proc/%d/stat", int (pid));
+
+    FILE* file = fopen (path, "r");
+
+    if (0 == file)
+        return 0;
+
+    char buf [1024];
+    const size_t n = fread (buf, 1, sizeof buf - 1, file);
+
+    fclose (file);
+    buf [n] = 0;
+
+    //
+    // The command, in parentheses, may hold anything; the state follows the
+    // last parenthesis, the start time is the 19th field after it:
+    //
+    const char* p = strrchr (buf, ')');
+
+    unsigned long long ticks = 0;
+    char state = 0;
+
+    if (0 == p || 2 != sscanf (
+            p + 1, " %c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d "
+            "%*d %*d %*d %*d %*d %llu", &state, &ticks))
+        return 0;
+
+    start = ticks;
+    return state;
+}
+
+//
+// Records the calling process, its start time before its id (see below):
+//
+void
+record (shm_process_t& process) {
+    uint64_t start = 0;
+    process_state (getpid (), start);
+
+    process.pid = 0;
+    process.start = start;
+    process.pid = getpid ();
+}
+
+//
+// Whether the process is the one recorded, and not gone: neither exited (a
+// zombie) nor replaced by another process of the same id:
+//
+bool
+is_alive (const shm_process_t& process) {
+    int32_t pid;
+    uint64_t start;
+
+    //
+    // Read consistently with an attach that records a new process:
+    //
+    do {
+        pid = process.pid;
+        start = process.start;
+    } while (pid != process.pid);
+
+    if (pid <= 0)
+        return false;
+
+    if (0 != kill (pid, 0) && ESRCH == errno)
+        return false;
+
+    uint64_t current = 0;
+    const char state = process_state (pid, current);
+
+    //
+    // Without /proc, the id is all there is to go by:
+    //
+    return 0 == state || ('Z' != state && 'X' != state && current == start);
+}
+
+//
+// A segment is left behind by a writer that did not get to unlink it, i.e.,
+// whose process is gone:
+//
+bool
+is_stale (const std::string& name) {
+    const int fd = shm_open (name.c_str (), O_RDONLY, 0);
+
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+
+    if (fstat (fd, &st) < 0) {
+        ::close (fd);
+        return false;
+    }
+
+    if (size_t (st.st_size) < sizeof (shm_header_t)) {
+        ::close (fd);
+
+        //
+        // Truncated, the writer died before sizing it:
+        //
+        return 0 == st.st_size;
+    }
+
+    void* addr = mmap (0, sizeof (shm_header_t), PROT_READ, MAP_SHARED, fd, 0);
+    ::close (fd);
+
+    if (MAP_FAILED == addr)
+        return false;
+
+    const auto h = static_cast< const shm_header_t* > (addr);
+
+    const bool stale = shm_magic == h->magic && !is_alive (h->writer);
+
+    munmap (addr, sizeof (shm_header_t));
+
+    return stale;
+}
+
+}
+
+shm_mapping_t::shm_mapping_t (
+    const std::string& name, size_t slots, size_t capacity)
+    : name_ (name), size_ (segment_size (slots, capacity)), owner_ (true) {
+    BS_ASSERT (slots > 0);
+
+    const int flags = O_CREAT | O_EXCL | O_RDWR;
+
+    int fd = shm_open (name.c_str (), flags, 0600);
+
+    //
+    // A segment of a previous writer is replaced if its process is gone; a
+    // live ring of the same name is an error:
+    //
+    if (fd < 0 && EEXIST == errno && is_stale (name)) {
+        shm_unlink (name.c_str ());
+        fd = shm_open (name.c_str (), flags, 0600);
+    }
+
+    if (fd < 0)
+        throw_errno ("shm_open");
+
+    if (ftruncate (fd, size_) < 0) {
+        const int error = errno;
+        ::close (fd), shm_unlink (name.c_str ());
+        throw system_error (error, generic_category (), "ftruncate");
+    }
+
+    addr_ = mmap (0, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close (fd);
+
+    if (MAP_FAILED == addr_) {
+        const int error = errno;
+        shm_unlink (name.c_str ());
+        throw system_error (error, generic_category (), "mmap");
+    }
+
+    auto h = new (addr_) shm_header_t;
+
+    h->slots = slots;
+    h->capacity = capacity;
+    record (h->writer);
+    h->reader.pid = 0;
+    h->reader.start = 0;
+    h->head = h->tail = h->closed = 0;
+    h->reader_event = h->writer_event = 0;
+    h->reader_waiting = h->writer_waiting = 0;
+
+    atomic_thread_fence (memory_order_release);
+    h->magic = shm_magic;
+}
+
+/* explicit */
+shm_mapping_t::shm_mapping_t (const std::string& name)
+    : name_ (name), owner_ (false) {
+    const int fd = shm_open (name.c_str (), O_RDWR, 0);
+
+    if (fd < 0)
+        throw_errno ("shm_open");
+
+    struct stat st;
+
+    if (fstat (fd, &st) < 0) {
+        const int error = errno;
+        ::close (fd);
+        throw system_error (error, generic_category (), "fstat");
+    }
+
+    size_ = st.st_size;
+
+    addr_ = mmap (0, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close (fd);
+
+    if (MAP_FAILED == addr_)
+        throw_errno ("mmap");
+
+    const auto h = header ();
+
+    if (size_ < sizeof *h || shm_magic != h->magic ||
+        size_ < segment_size (h->slots, h->capacity)) {
+        munmap (addr_, size_);
+        throw std::runtime_error ("not a frame ring: " + name);
+    }
+}
+
+shm_mapping_t::shm_mapping_t (shm_mapping_t&& other)
+    : name_ (std::move (other.name_)), addr_ (other.addr_),
+      size_ (other.size_), owner_ (other.owner_) {
+    other.addr_ = 0;
+    other.owner_ = false;
+}
+
+shm_mapping_t&
+shm_mapping_t::operator= (shm_mapping_t&& other) {
+    std::swap (name_, other.name_);
+    std::swap (addr_, other.addr_);
+    std::swap (size_, other.size_);
+    std::swap (owner_, other.owner_);
+    return *this;
+}
+
+shm_mapping_t::~shm_mapping_t () {
+    if (addr_)
+        munmap (addr_, size_);
+
+    if (owner_)
+        shm_unlink (name_.c_str ());
+}
+
+shm_header_t*
+shm_mapping_t::header () const {
+    return static_cast< shm_header_t* > (addr_);
+}
+
+shm_slot_t*
+shm_mapping_t::slot (size_t i) const {
+    const auto h = header ();
+
+    return reinterpret_cast< shm_slot_t* > (
+        static_cast< unsigned char* > (addr_) + align (sizeof *h) +
+        (i % h->slots) * slot_size (h->capacity));
+}
+
+unsigned char*
+shm_mapping_t::data (size_t i) const {
+    return reinterpret_cast< unsigned char* > (slot (i)) +
+        align (sizeof (shm_slot_t));
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////
+
+/* explicit */
+shm_writer_t::shm_writer_t (
+    const std::string& name, size_t slots, size_t capacity)
+    : mapping_ (name, slots, capacity), head_ { }, acquired_ { }
+{ }
+
+shm_writer_t::~shm_writer_t () {
+    close ();
+}
+
+cv::Mat
+shm_writer_t::acquire (int rows, int cols, int type) {
+    auto& h = *mapping_.header ();
+
+    const size_t step = cols * CV_ELEM_SIZE (type);
+
+    if (rows * step > h.capacity)
+        throw std::length_error ("frame exceeds the ring slot capacity");
+
+    //
+    // Wait for the reader to release a slot, if the ring is full; for one to
+    // attach, if none has yet, but not for one that detached or died:
+    //
+    for (bool waited = false; head_ - h.tail >= h.slots; waited = true) {
+        if (waited && 0 != h.reader.pid && !detail::is_alive (h.reader))
+            throw system_error (EPIPE, generic_category (), "shm reader gone");
+
+        detail::wait_for (h.writer_event, h.writer_waiting, [&] {
+            return head_ - h.tail < h.slots;
+        });
+    }
+
+    auto& slot = *mapping_.slot (head_);
+
+    slot.rows = rows;
+    slot.cols = cols;
+    slot.type = type;
+    slot.step = step;
+
+    acquired_ = true;
+
+    return cv::Mat (rows, cols, type, mapping_.data (head_), step);
+}
+
+void
+shm_writer_t::publish () {
+    BS_ASSERT (acquired_);
+
+    auto& h = *mapping_.header ();
+
+    h.head = ++head_;
+    acquired_ = false;
+
+    detail::notify (h.reader_event, h.reader_waiting);
+}
+
+shm_writer_t&
+shm_writer_t::operator<< (const cv::Mat& frame) {
+    auto dst = acquire (frame.rows, frame.cols, frame.type ());
+    frame.copyTo (dst);
+
+    return publish (), *this;
+}
+
+void
+shm_writer_t::close () {
+    auto h = mapping_.header ();
+
+    if (h && 0 == h->closed) {
+        h->closed = 1;
+        detail::notify (h->reader_event, h->reader_waiting);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+/* explicit */
+shm_reader_t::shm_reader_t (const std::string& name)
+    : mapping_ (name), tail_ (mapping_.header ()->tail), holding_ { } {
+    auto& h = *mapping_.header ();
+
+    //
+    // A single reader at a time; the place of one that is gone is free:
+    //
+    if (detail::is_alive (h.reader))
+        throw system_error (EBUSY, generic_category (), "shm reader attached");
+
+    detail::record (h.reader);
+}
+
+shm_reader_t::~shm_reader_t () {
+    release ();
+
+    auto& h = *mapping_.header ();
+
+    h.reader.pid = -1;
+    detail::notify (h.writer_event, h.writer_waiting);
+}
+
+void
+shm_reader_t::release () {
+    if (holding_) {
+        auto& h = *mapping_.header ();
+
+        h.tail = ++tail_;
+        holding_ = false;
+
+        detail::notify (h.writer_event, h.writer_waiting);
+    }
+}
+
+bool
+shm_reader_t::read (cv::Mat& frame) {
+    release ();
+
+    auto& h = *mapping_.header ();
+
+    for (bool waited = false; tail_ == h.head; waited = true) {
+        //
+        // A writer that died without closing the stream ends it all the same:
+        //
+        if (h.closed || (waited && !detail::is_alive (h.writer))) {
+            //
+            // Published frames are visible before the flag, check again:
+            //
+            if (tail_ != h.head)
+                break;
+
+            return frame.release (), false;
+        }
+
+        detail::wait_for (h.reader_event, h.reader_waiting, [&] {
+            return tail_ != h.head || h.closed;
+        });
+    }
+
+    const auto& slot = *mapping_.slot (tail_);
+
+    frame = cv::Mat (slot.rows, slot.cols, slot.type,
+                     mapping_.data (tail_), slot.step);
+
+    return holding_ = true;
+}
+
+}
@@ -1,36 +1,69 @@
 #include <bs/utils.hpp>
+#include <bs/ewma.hpp>
 #include <bs/sigma_delta.hpp>
 
 #include <opencv2/imgproc.hpp>
 
 #include <iostream>
+#include <stdexcept>
 using namespace std;
 
 namespace bs {
 
+namespace {
+
+inline double
+depth_max (const cv::Mat& arg) {
+    switch (arg.type ()) {
+    case CV_8UC1:  return 255.;
+    case CV_16UC1: return 65535.;
+
+    default:
+        throw std::invalid_argument ("unsupported array type");
+    }
+}
+
+}
+
+//
+// The state is kept at the depth of the frames, 8-bit or 16-bit gray; the mask
+// is 8-bit regardless:
+//
+
 /* explicit */
 sigma_delta_t::sigma_delta_t (
-    const cv::Mat& b, size_t n, size_t Vmin, size_t Vmax)
-    : detail::base_t (b, { b.size (), CV_8U, cv::Scalar (0) }),
+    const cv::Mat& b, size_t n, size_t Vmin, size_t Vmax, const execution_t& x)
+    : detail::base_t (b, { b.size (), CV_8U, cv::Scalar (0) }, x),
       m_ (b.clone ()),
-      d_ (b.size (), CV_8U, cv::Scalar (0)),
-      v_ (b.size (), CV_8U, cv::Scalar (0)),
-      q_ (b.size (), CV_8U, cv::Scalar (255)),
-      n_ (n), Vmin_ (Vmin), Vmax_ (Vmax)
+      d_ (b.size (), b.type (), cv::Scalar (0)),
+      v_ (b.size (), b.type (), cv::Scalar (0)),
+      q_ (b.size (), b.type (), cv::Scalar (depth_max (b))),
+      n_ (n), Vmin_ (Vmin), Vmax_ (Vmax), max_ (depth_max (b))
 { }
 
 const cv::Mat&
 sigma_delta_t::operator() (const cv::Mat& frame) {
+    const execution_scope_t scope (execution_);
+
+    BS_ASSERT (frame.type () == m_.type ());
+
     //
     // m_ is M_t, a running approximation of the median:
     //
-    m_ = m_ + threshold (frame - m_, 0, 1) - threshold (m_ - frame, 0, 1);
+    cv::subtract (frame, m_, a_);
+    threshold (a_, a_, 0, 1);
+
+    cv::subtract (m_, frame, b_);
+    threshold (b_, b_, 0, 1);
+
+    cv::add (m_, a_, m_);
+    cv::subtract (m_, b_, m_);
 
     //
     // d_ is Δ_t, an absolute difference between the frame and the
     // running median:
     //
-    d_ = absdiff (frame, m_);
+    absdiff (frame, m_, d_);
 
     //
     // ... we also use this filter to compute the time-variance of the pixels,
@@ -51,34 +84,75 @@ sigma_delta_t::operator() (const cv::Mat& frame) {
     //
     // sgn(N×Δ_t - V_{t-1})
     //
-    cv::Mat tmp = n_ * d_;
-    tmp = threshold (tmp - v_, 0, 1) - threshold (v_ - tmp, 0, 1);
+    d_.convertTo (c_, -1, double (n_));
+
+    cv::subtract (c_, v_, a_);
+    threshold (a_, a_, 0, 1);
+
+    cv::subtract (v_, c_, b_);
+    threshold (b_, b_, 0, 1);
+
+    cv::subtract (a_, b_, c_);
 
     //
     // Mask all Δ_t zeroes:
     //
-    cv::Mat mask = threshold (d_, 1, 1);
-    tmp = tmp.mul (mask);
+    threshold (d_, a_, 1, 1);
+    cv::multiply (c_, a_, c_);
 
     //
     // V_t = V_{t-1} + sgn(N×Δ_t - V_{t-1}), Δ_t ≠ 0
     //
-    v_ = v_ + tmp;
+    cv::add (v_, c_, v_);
 
     //
     // V_t = max(min(Vmax, V_t), Vmin)
     //
-    v_ = threshold (v_, Vmax_, 0, cv::THRESH_TRUNC);
+    threshold (v_, v_, Vmax_, 0, cv::THRESH_TRUNC);
 
-    v_ = q_ - v_;
-    v_ = threshold (v_, 255 - Vmin_, 0, cv::THRESH_TRUNC);
+    cv::subtract (q_, v_, v_);
+    threshold (v_, v_, max_ - Vmin_, 0, cv::THRESH_TRUNC);
 
-    v_ = q_ - v_;
+    cv::subtract (q_, v_, v_);
 
     //
     // Ê_t = (O_t < V_t) ? 0 : 1
     //
-    return mask_ = threshold (d_ - v_, 0, 255);
+    cv::subtract (d_, v_, a_);
+    threshold (a_, a_, 0, 255);
+
+    mask_from (a_, mask_);
+
+    return emit_mask ();
+}
+
+void
+sigma_delta_t::bootstrap (const std::vector< cv::Mat >& frames) {
+    const execution_scope_t scope (execution_);
+
+    BS_ASSERT (!frames.empty ());
+
+    window_median_t f (frames.size ());
+
+    for (const auto& frame : frames) {
+        BS_ASSERT (frame.type () == m_.type ());
+        f (frame);
+    }
+
+    f.value ().copyTo (m_);
+    m_.copyTo (background_);
+
+    //
+    // V_0 = N × mean |I - M_0|, within [Vmin, Vmax]:
+    //
+    cv::Mat sum = cv::Mat::zeros (m_.size (), CV_32F);
+
+    for (const auto& frame : frames)
+        cv::accumulate (absdiff (frame, m_), sum);
+
+    sum.convertTo (v_, v_.type (), double (n_) / frames.size ());
+
+    v_ = cv::max (cv::min (v_, double (Vmax_)), double (Vmin_));
 }
 
 }
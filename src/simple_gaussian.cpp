@@ -1,69 +1,244 @@
+#include <bs/cpu.hpp>
 #include <bs/utils.hpp>
 #include <bs/simple_gaussian.hpp>
 
 #include <opencv2/imgproc.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <type_traits>
 using namespace std;
 
+namespace {
+
+//
+// The row kernels, compiled per instruction set tier (see BS_CLONES); the tag
+// carries the number of channels:
+//
+template< int N >
+using channels_t = std::integral_constant< int, N >;
+
+//
+// Tests a row of pixels against their Gaussians and updates these (see the
+// model below):
+//
+template< typename T, int N >
+BS_INLINE void
+update_row (const T* src, float* const* m, float* const* r, unsigned char* k,
+            int n, float a, float decay, float scale, float threshold,
+            channels_t< N >) {
+#pragma omp simd
+    for (int j = 0; j < n; ++j) {
+        float d [N], distance = 0, norm = 0;
+
+        for (int c = 0; c < N; ++c) {
+            d [c] = src [N * j + c] * scale - m [c][j];
+
+            //
+            // Squared normalized Euclidean distance:
+            //
+            distance += d [c] * d [c] * r [c][j];
+            norm += d [c] * d [c];
+        }
+
+        k [j] = distance > threshold ? 255 : 0;
+
+        //
+        // Rolling mean and variance:
+        //
+        r [0][j] = r [0][j] * decay / (1 + r [0][j] * a * norm);
+
+        for (int c = 1; c < N; ++c)
+            r [c][j] *= decay;
+
+        for (int c = 0; c < N; ++c)
+            m [c][j] += a * d [c];
+    }
+}
+
+BS_CLONES (update_row)
+
+//
+// Accumulates one channel of a row of a frame, and its square, into m and r:
+//
+template< typename T, int N >
+BS_INLINE void
+accumulate_row (const T* src, float* m, float* r, int n, float scale,
+                channels_t< N >) {
+#pragma omp simd
+    for (int j = 0; j < n; ++j) {
+        const float x = src [N * j] * scale;
+
+        m [j] += x;
+        r [j] += x * x;
+    }
+}
+
+BS_CLONES (accumulate_row)
+
+//
+// The mean and the reciprocal of the (floored) variance of the sums above,
+// over count frames, in place:
+//
+BS_INLINE void
+moments_row (float* m, float* r, int n, float count, float min_variance) {
+#pragma omp simd
+    for (int j = 0; j < n; ++j) {
+        const float mean = m [j] / count;
+        const float variance = r [j] / count - mean * mean;
+
+        m [j] = mean;
+        r [j] = 1 / (std::max) (variance, min_variance);
+    }
+}
+
+BS_CLONES (moments_row)
+
+}
+
 namespace bs {
 
+template< typename T >
 /* explicit */
-simple_gaussian_t::simple_gaussian_t (
-    const cv::Mat& b, float a, float t)
-    : detail::base_t (b, { b.size (), CV_8U, cv::Scalar (0) }),
-      m_ (bs::float_from (b)), v_ (b.size (), CV_32FC3, { .6, .6, .6 }),
-      alpha_ (a), threshold_ (t * t)
-{ }
+basic_simple_gaussian_t< T >::basic_simple_gaussian_t (
+    const cv::Mat& b, float a, float t, const execution_t& x)
+    : detail::base_t (b.clone (), { b.size (), CV_8U, cv::Scalar (0) }, x),
+      alpha_ (a), threshold_ (t * t) {
+    BS_ASSERT (b.type () == detail::pixel_traits< T >::type);
+
+    cv::split (bs::float_from (b, 1. / detail::pixel_traits< T >::max), m_);
 
+    for (int c = 0; c < detail::pixel_traits< T >::channels; ++c)
+        r_.emplace_back (b.size (), CV_32F, cv::Scalar (1 / .6));
+}
+
+//
+// The mean and the variance are updated as:
+//
+//   m' = m + a d
+//   v' = (1 - a) (v + a |d|^2)    for the first channel,
+//   v' = (1 - a) v                for the others (as it always was),
+//
+// where d = x - m; the reciprocal of the variance is updated in place, with a
+// single division per pixel:
+//
+//   r' = r / ((1 - a) (1 + r a |d|^2))
+//
+template< typename T >
 const cv::Mat&
-simple_gaussian_t::operator() (const cv::Mat& frame) {
-    auto mul = [](const cv::Vec3f& a, const cv::Vec3f& b) -> cv::Vec3f {
-        return { a [0] * b [0] + a [1] * b [1] + a [2] * b [2] };
-    };
+basic_simple_gaussian_t< T >::operator() (const cv::Mat& frame) {
+    const execution_scope_t scope (execution_);
+
+    using traits_type = detail::pixel_traits< T >;
+    using value_type = typename traits_type::value_type;
+
+    static constexpr int N = traits_type::channels;
+
+    BS_ASSERT (frame.type () == traits_type::type);
+    BS_ASSERT (frame.size () == mask_.size ());
+
+    const float a = alpha_, threshold = threshold_;
+    const float decay = 1 / (1 - a), scale = 1 / traits_type::max;
 
 #pragma omp parallel for
-    for (size_t i = 0; i < frame.total (); ++i) {
-        const auto& src = cv::Vec3f (frame.at< cv::Vec3b > (i)) / 255;
+    for (int i = 0; i < frame.rows; ++i) {
+        const value_type* src = frame.ptr< value_type > (i);
+
+        unsigned char* k = mask_.ptr< unsigned char > (i);
 
-        auto& m = m_.at< cv::Vec3f > (i);
-        auto& v = v_.at< cv::Vec3f > (i);
+        float *m [N], *r [N];
 
-        float a, b, c;
+        for (int c = 0; c < N; ++c) {
+            m [c] = m_ [c].ptr< float > (i);
+            r [c] = r_ [c].ptr< float > (i);
+        }
 
-        a = src [0] - m [0];
-        b = src [1] - m [1];
-        c = src [2] - m [2];
+        update_row_dispatch (
+            src, m, r, k, frame.cols, a, decay, scale, threshold,
+            channels_t< N > ());
+    }
 
-        //
-        // Squared normalized Euclidean distance:
-        //
-        const float distance =
-            a * a / v [0] +
-            b * b / v [1] +
-            c * c / v [2];
+    invalidate_background ();
 
-        mask_.at< unsigned char > (i) = distance > threshold_ ? 255 : 0;
+    return emit_mask ();
+}
 
-        //
-        // Rolling mean and variance:
-        //
-        {
-            auto diff = src - m;
+//
+// The variance is floored, for static pixels, so that a deviation of 8 levels
+// of an 8-bit frame on every channel, i.e., sensor noise, stays within the
+// threshold, which is in units of the standard deviation:
+//
+template< typename T >
+void
+basic_simple_gaussian_t< T >::bootstrap (const std::vector< cv::Mat >& frames) {
+    const execution_scope_t scope (execution_);
 
-            auto inc = alpha_ * diff;
-            m += inc;
+    using traits_type = detail::pixel_traits< T >;
+    using value_type = typename traits_type::value_type;
 
-            v = (1 - alpha_) * (v + mul (diff, inc));
-        }
+    static constexpr int N = traits_type::channels;
+    static constexpr float noise = 8.f / 255;
 
-        //
-        // Update the background:
-        //
-        background_.at< cv::Vec3b > (i) = cv::Vec3b (m * 255);
+    BS_ASSERT (!frames.empty ());
+    BS_ASSERT (threshold_ > 0);
+
+    const float min_variance = N * noise * noise / threshold_;
+
+    for (const auto& frame : frames) {
+        BS_ASSERT (frame.type () == traits_type::type);
+        BS_ASSERT (frame.size () == mask_.size ());
+    }
+
+    const float scale = 1 / traits_type::max, n = frames.size ();
+
+#pragma omp parallel for
+    for (int i = 0; i < mask_.rows; ++i) {
+        for (int c = 0; c < N; ++c) {
+            float* m = m_ [c].ptr< float > (i);
+            float* r = r_ [c].ptr< float > (i);
+
+            std::fill (m, m + mask_.cols, 0.f);
+            std::fill (r, r + mask_.cols, 0.f);
+
+            //
+            // The sums of the values and of their squares, in r:
+            //
+            for (const auto& frame : frames)
+                accumulate_row_dispatch (
+                    frame.ptr< value_type > (i) + c, m, r, mask_.cols, scale,
+                    channels_t< N > ());
+
+            moments_row_dispatch (m, r, mask_.cols, n, min_variance);
+        }
     }
 
-    return mask_;
+    invalidate_background ();
+}
+
+template< typename T >
+void
+basic_simple_gaussian_t< T >::materialize () const {
+    using traits_type = detail::pixel_traits< T >;
+    using value_type = typename traits_type::value_type;
+
+    static constexpr int N = traits_type::channels;
+
+#pragma omp parallel for
+    for (int i = 0; i < background_.rows; ++i) {
+        value_type* dst = background_.ptr< value_type > (i);
+
+        for (int c = 0; c < N; ++c) {
+            const float* m = m_ [c].ptr< float > (i);
+
+            for (int j = 0; j < background_.cols; ++j)
+                dst [N * j + c] = cv::saturate_cast< value_type > (
+                    m [j] * traits_type::max);
+        }
+    }
 }
 
+template struct basic_simple_gaussian_t< unsigned char >;
+template struct basic_simple_gaussian_t< unsigned short >;
+template struct basic_simple_gaussian_t< cv::Vec3b >;
+
 }
@@ -1,121 +1,295 @@
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 #include <bs/utils.hpp>
 #include <bs/temporal_median.hpp>
 
+#if defined (_OPENMP)
+#  include <omp.h>
+#endif // _OPENMP
+
 namespace bs {
 
 temporal_median_t::temporal_median_t (
-    const cv::Mat& b, size_t h, size_t i, size_t lo, size_t hi)
-    : detail::base_t (b.clone (), { b.size (), CV_8U }), history_ (h),
-    lo_ (lo), hi_ (hi), frame_interval_ (i), frame_counter_ { }
-{ }
-
-cv::Mat
-temporal_median_t::calculate_median () const {
-    cv::Mat median (background_.size (), CV_8U);
+    const cv::Mat& b, size_t h, size_t i, size_t lo, size_t hi, bool hysteresis,
+    const execution_t& x)
+    : detail::base_t (b.clone (), { b.size (), CV_8U }, x), history_ (h),
+    lo_ (lo), hi_ (hi), frame_interval_ (i), frame_counter_ { },
+    hysteresis_ (hysteresis),
+    components_ (1, (std::numeric_limits< size_t >::max) (), 8) {
+    BS_ASSERT (b.type () == CV_8UC1 || b.type () == CV_16UC1);
+}
 
+template< typename T >
+void
+temporal_median_t::calculate_median () {
     const auto n = history_.size () + 1;
-    std::vector< unsigned char > buf (n);
 
-#pragma omp parallel for
-    for (size_t i = 0; i < median.total (); ++i) {
-        //
-        // Extract pixel history from the historic frames:
-        //
-        std::transform (
-            history_.begin (), history_.end (), buf.begin (), [&](auto& x) {
-                return x.template at< unsigned char > (i);
-            });
+#if defined (_OPENMP)
+    buf_.resize (n * omp_get_max_threads ());
+#else
+    buf_.resize (n);
+#endif // _OPENMP
 
-        //
-        // Use the current background, i.e., the median from the previous
-        // iteration:
-        //
-        buf.back () = background_.at< unsigned char > (i);
+#pragma omp parallel
+    {
+#if defined (_OPENMP)
+        const auto buf = buf_.begin () + n * omp_get_thread_num ();
+#else
+        const auto buf = buf_.begin ();
+#endif // _OPENMP
 
-        //
-        // Sort the set of historic pixels and current background pixel at the
-        // position based on their gray levels:
-        //
-        std::sort (buf.begin (), buf.end ());
+#pragma omp for
+        for (size_t i = 0; i < background_.total (); ++i) {
+            //
+            // Extract pixel history from the historic frames:
+            //
+            std::transform (
+                history_.begin (), history_.end (), buf, [&](auto& x) {
+                    return x.template at< T > (i);
+                });
 
-        //
-        // The median is the new background:
-        //
-        median.at< unsigned char > (i) = buf [n / 2];
+            //
+            // Use the current background, i.e., the median from the
+            // previous iteration:
+            //
+            buf [n - 1] = background_.at< T > (i);
+
+            //
+            // Sort the set of historic pixels and current background pixel at
+            // the position based on their gray levels:
+            //
+            std::sort (buf, buf + n);
+
+            //
+            // The median is the new background, in place; each pixel only
+            // reads its own:
+            //
+            background_.at< T > (i) = T (buf [n / 2]);
+        }
     }
+}
 
-    return median;
+void
+temporal_median_t::push_history (const cv::Mat& frame) {
+    cv::Mat slot;
+
+    if (history_.full ())
+        slot = history_.front ();
+
+    frame.copyTo (slot);
+    history_.push_back (slot);
 }
 
-cv::Mat
-temporal_median_t::merge_masks (const cv::Mat& lo_mask, const cv::Mat& hi_mask) {
-    const unsigned char *p = lo_mask.data, *q = hi_mask.data;
+//
+// A pixel is marked as foreground ... if it is presented(sic) in the
+// low-thresholded binarized mask AND it is spatially connected to at least one
+// pixel present in the high-thresholded binarized mask.
+//
+// Both thresholds are applied on the fly: the high-thresholded rows above,
+// at and below a row are OR-ed into a padded row buffer, which is dilated
+// horizontally by shifted reads; the border rows and columns see background
+// beyond the frame:
+//
+template< typename T >
+void
+temporal_median_t::merge_masks (const cv::Mat& diff) {
+    const int rows = diff.rows, cols = diff.cols;
 
-    const size_t w = lo_mask.cols, h = lo_mask.rows;
-    cv::Mat mask (h, w, CV_8U, cv::Scalar (0));
+    const T lo = (std::min) (lo_, size_t ((std::numeric_limits< T >::max) ()));
+    const T hi = (std::min) (hi_, size_t ((std::numeric_limits< T >::max) ()));
 
-    unsigned char* r = mask.data;
+    mask_.create (diff.size (), CV_8U);
 
-#pragma omp parallel for
-    for (size_t i = 1; i < h - 1; ++i) {
-        for (size_t j = 1; j < w - 1; ++j) {
+#pragma omp parallel
+    {
+        std::vector< unsigned char > buf (cols + 2, 0);
+        unsigned char* u = buf.data () + 1;
 
-            const size_t pos = i * w + j;
-            BS_ASSERT (pos < w * h);
+#pragma omp for
+        for (int i = 0; i < rows; ++i) {
+            const T* q = diff.ptr< T > (i);
 
-            //
-            // A pixel is marked as foreground ... if it is presented(sic) in
-            // the low-thresholded binarized mask AND it is spatially connected
-            // to at least one pixel present in the high-thresholded binarized
-            // mask:
-            //
-            if (q [pos] || p [pos] && (
-                    q [pos - w - 1] ||
-                    q [pos - w] ||
-                    q [pos - w + 1] ||
-                    q [pos - 1] ||
-                    q [pos + 1] ||
-                    q [pos + w - 1] ||
-                    q [pos + w] ||
-                    q [pos + w + 1])) {
-                r [pos] = 255;
+#pragma omp simd
+            for (int j = 0; j < cols; ++j)
+                u [j] = q [j] > hi;
+
+            if (i > 0) {
+                const T* p = diff.ptr< T > (i - 1);
+
+#pragma omp simd
+                for (int j = 0; j < cols; ++j)
+                    u [j] |= p [j] > hi;
+            }
+
+            if (i + 1 < rows) {
+                const T* r = diff.ptr< T > (i + 1);
+
+#pragma omp simd
+                for (int j = 0; j < cols; ++j)
+                    u [j] |= r [j] > hi;
             }
+
+            unsigned char* dst = mask_.ptr< unsigned char > (i);
+
+#pragma omp simd
+            for (int j = 0; j < cols; ++j) {
+                const bool near = u [j - 1] | u [j] | u [j + 1];
+                dst [j] = (q [j] > hi) | ((q [j] > lo) & near) ? 255 : 0;
+            }
+        }
+    }
+}
+
+//
+// The low-thresholded mask is labeled into 8-connected components, runs joined
+// by a union-find over horizontal bands in parallel (see blobs_t); components
+// with a run that holds a high-threshold pixel are kept whole:
+//
+template< typename T >
+void
+temporal_median_t::hysteresis (const cv::Mat& diff) {
+    const T lo = (std::min) (lo_, size_t ((std::numeric_limits< T >::max) ()));
+    const T hi = (std::min) (hi_, size_t ((std::numeric_limits< T >::max) ()));
+
+    mask_.create (diff.size (), CV_8U);
+
+#pragma omp parallel for
+    for (int i = 0; i < diff.rows; ++i) {
+        const T* p = diff.ptr< T > (i);
+        unsigned char* q = mask_.ptr< unsigned char > (i);
+
+#pragma omp simd
+        for (int j = 0; j < diff.cols; ++j)
+            q [j] = p [j] > lo ? 255 : 0;
+    }
+
+#if defined (_OPENMP)
+    //
+    // As many bands as the execution context has threads:
+    //
+    components_.tiles (omp_get_max_threads ());
+#endif // _OPENMP
+
+    components_ (mask_);
+
+    const auto& runs = components_.runs ();
+    const auto& labels = components_.labels ();
+
+    seeded_.assign (components_.components (), 0);
+
+#pragma omp parallel for
+    for (size_t k = 0; k < runs.size (); ++k) {
+        const auto& run = runs [k];
+        const T* p = diff.ptr< T > (run.row);
+
+        if (std::any_of (p + run.begin, p + run.end, [=](T x) { return x > hi; })) {
+#pragma omp atomic write
+            seeded_ [labels [k]] = 1;
+        }
+    }
+
+#pragma omp parallel for
+    for (size_t k = 0; k < runs.size (); ++k) {
+        const auto& run = runs [k];
+
+        if (0 == seeded_ [labels [k]]) {
+            unsigned char* q = mask_.ptr< unsigned char > (run.row);
+            std::fill (q + run.begin, q + run.end, 0);
         }
     }
+}
+
+void
+temporal_median_t::bootstrap (const std::vector< cv::Mat >& frames) {
+    const execution_scope_t scope (execution_);
+
+    BS_ASSERT (!frames.empty ());
+
+    for (const auto& x : frames) {
+        BS_ASSERT (x.type () == background_.type ());
+        BS_ASSERT (x.size () == background_.size ());
+    }
+
+    //
+    // The frames are picked backwards from the last, as far apart as the
+    // frame interval allows while filling the history:
+    //
+    const size_t n = frames.size (), capacity = history_.capacity ();
+    const size_t step = (std::max) (
+        size_t (1), (std::min) (frame_interval_, n / capacity));
+
+    std::vector< const cv::Mat* > picked;
+
+    for (size_t k = n; k > 0 && picked.size () < capacity; k -= (std::min) (k, step))
+        picked.push_back (&frames [k - 1]);
+
+    history_.clear ();
 
-    return mask;
+    for (auto iter = picked.rbegin (); iter != picked.rend (); ++iter)
+        history_.push_back ((*iter)->clone ());
+
+    picked.back ()->copyTo (background_);
+
+    if (CV_8U == background_.depth ())
+        calculate_median< unsigned char > ();
+    else
+        calculate_median< unsigned short > ();
+
+    frame_counter_ = 0;
 }
 
 const cv::Mat&
 temporal_median_t::operator () (const cv::Mat& frame) {
+    const execution_scope_t scope (execution_);
+
+    BS_ASSERT (frame.type () == background_.type ());
+
     if (history_.size () < history_.capacity ()) {
         //
-        // Store frames until the history buffer is full:
+        // Store frames until the history buffer is full, nothing is detected
+        // meanwhile:
         //
-        return history_.push_back (frame), mask_ = frame;
+        push_history (frame);
+        mask_.setTo (cv::Scalar (0));
+
+        return emit_mask ();
     }
     else {
         //
         // Compute the mask -- as a plain absolute difference between the
         // incoming frame and background:
         //
-        cv::Mat diff = absdiff (frame, background_);
+        absdiff (frame, background_, diff_);
 
-        auto median = calculate_median ();
-        median.copyTo (background_);
+        if (CV_8U == frame.depth ())
+            calculate_median< unsigned char > ();
+        else
+            calculate_median< unsigned short > ();
 
         if (0 == (++frame_counter_ % frame_interval_))
-            history_.push_back (frame);
+            push_history (frame);
 
         //
-        // Create two masks: a "low threshold" mask and a "high threshold"
-        // mask. This approach uses a pair of simpler, global threshold masks,
-        // than the algorithm described in the cited paper:
+        // Threshold at two levels: a "low threshold" mask and a "high
+        // threshold" mask. This approach uses a pair of simpler, global
+        // threshold masks, than the algorithm described in the cited paper:
         //
-        return mask_ = merge_masks (
-            threshold (diff, lo_), threshold (diff, hi_));
+        if (hysteresis_) {
+            if (CV_8U == diff_.depth ())
+                hysteresis< unsigned char > (diff_);
+            else
+                hysteresis< unsigned short > (diff_);
+        }
+        else {
+            if (CV_8U == diff_.depth ())
+                merge_masks< unsigned char > (diff_);
+            else
+                merge_masks< unsigned short > (diff_);
+        }
+
+        return emit_mask ();
     }
 }
 
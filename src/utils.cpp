@@ -0,0 +1,141 @@
+#include <bs/utils.hpp>
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+namespace bs {
+namespace detail {
+
+namespace {
+
+//
+// The source pixels an output pixel of an area resampling covers, along one
+// axis: the first of them, and their fractional coverage as weights, the
+// weights of output o being weight [offset [o]] to weight [offset [o + 1]]:
+//
+struct area_taps_t {
+    area_taps_t (int src, int dst) {
+        const double scale = double (src) / dst;
+
+        offset.push_back (0);
+
+        for (int o = 0; o < dst; ++o) {
+            const double lo = o * scale;
+            const double hi = (std::min) ((o + 1) * scale, double (src));
+
+            int i = int (lo);
+            first.push_back (i);
+
+            for (; i < src && i < hi; ++i) {
+                const double w = (std::min) (hi, i + 1.) - (std::max) (lo, double (i));
+                weight.push_back (float (w / (hi - lo)));
+            }
+
+            offset.push_back (int (weight.size ()));
+        }
+    }
+
+    vector< int > first, offset;
+    vector< float > weight;
+};
+
+//
+// The BT.601 luma weights of cv::COLOR_BGR2GRAY:
+//
+constexpr float kb = .114f, kg = .587f, kr = .299f;
+
+//
+// Area resampling of 8-bit frames of C channels to D channels, D being C or 1
+// (gray): each output row accumulates its source rows, weighted and converted
+// on the fly, into a row of floats which is then reduced horizontally. The
+// source is read once, without a full resolution temporary:
+//
+template< int C, int D >
+void
+area_resample (const cv::Mat& src, cv::Mat& dst, cv::Size size) {
+    static_assert (D == C || 1 == D, "unsupported conversion");
+
+    BS_ASSERT (src.type () == CV_8UC (C));
+    BS_ASSERT (size.width > 0 && size.height > 0);
+
+    const area_taps_t xs (src.cols, size.width), ys (src.rows, size.height);
+
+    dst.create (size, CV_8UC (D));
+
+    const int cols = src.cols;
+
+#pragma omp parallel
+    {
+        vector< float > buf (size_t (cols) * D);
+        float* acc = buf.data ();
+
+#pragma omp for
+        for (int i = 0; i < size.height; ++i) {
+            std::fill (buf.begin (), buf.end (), 0.f);
+
+            for (int t = ys.offset [i], y = ys.first [i];
+                 t < ys.offset [i + 1]; ++t, ++y) {
+                const unsigned char* p = src.ptr< unsigned char > (y);
+                const float w = ys.weight [t];
+
+                if constexpr (3 == C && 1 == D) {
+                    const float b = w * kb, g = w * kg, r = w * kr;
+
+#pragma omp simd
+                    for (int j = 0; j < cols; ++j)
+                        acc [j] += b * p [3 * j] + g * p [3 * j + 1] + r * p [3 * j + 2];
+                }
+                else {
+#pragma omp simd
+                    for (int j = 0; j < cols * D; ++j)
+                        acc [j] += w * p [j];
+                }
+            }
+
+            unsigned char* d = dst.ptr< unsigned char > (i);
+
+            for (int j = 0; j < size.width; ++j) {
+                const float* q = acc + xs.first [j] * D;
+                const float* w = xs.weight.data () + xs.offset [j];
+
+                const int n = xs.offset [j + 1] - xs.offset [j];
+
+                for (int c = 0; c < D; ++c) {
+                    float s = 0;
+
+                    for (int k = 0; k < n; ++k)
+                        s += w [k] * q [k * D + c];
+
+                    d [j * D + c] = cv::saturate_cast< unsigned char > (s);
+                }
+            }
+        }
+    }
+}
+
+}
+
+void
+area_gray (const cv::Mat& src, cv::Mat& dst, cv::Size size) {
+    switch (src.type ()) {
+    case CV_8UC1: area_resample< 1, 1 > (src, dst, size); break;
+    case CV_8UC3: area_resample< 3, 1 > (src, dst, size); break;
+
+    default:
+        throw std::invalid_argument ("unsupported array type");
+    }
+}
+
+void
+area_resize (const cv::Mat& src, cv::Mat& dst, cv::Size size) {
+    switch (src.type ()) {
+    case CV_8UC1: area_resample< 1, 1 > (src, dst, size); break;
+    case CV_8UC3: area_resample< 3, 3 > (src, dst, size); break;
+
+    default:
+        throw std::invalid_argument ("unsupported array type");
+    }
+}
+
+}}
@@ -0,0 +1,122 @@
+// -*- mode: c++ -*-
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE area
+
+#include <bs/utils.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <opencv2/imgproc.hpp>
+
+BOOST_AUTO_TEST_SUITE(area)
+
+//
+// Odd sizes, integer and non-integer downscaling factors:
+//
+static const cv::Size sizes [] = {
+    { 641, 479 }, { 333, 187 }, { 97, 61 }, { 64, 48 }
+};
+
+static const double factors [] = { .5, .25, .37, 2. / 3, .3, .9 };
+
+static cv::Mat
+make_frame (cv::Size size, int type) {
+    cv::Mat frame (size, type);
+
+    cv::RNG rng (size.width * size.height + type);
+    rng.fill (frame, cv::RNG::UNIFORM, 0, 256);
+
+    //
+    // Smooth enough for the gray conversion to not matter much, besides noise:
+    //
+    cv::Mat smooth;
+    cv::blur (frame, smooth, cv::Size (5, 5));
+
+    return smooth + frame / 8;
+}
+
+//
+// Within one level of rounding, the area resampling is a single pass of float
+// accumulation where OpenCV rounds after the conversion and after the resize:
+//
+static bool
+close (const cv::Mat& a, const cv::Mat& b) {
+    return a.size () == b.size () && a.type () == b.type () &&
+        cv::norm (a, b, cv::NORM_INF) <= 1;
+}
+
+BOOST_AUTO_TEST_CASE (resize) {
+    for (int type : { CV_8UC1, CV_8UC3 }) {
+        for (const auto& size : sizes) {
+            const cv::Mat frame = make_frame (size, type);
+
+            for (double factor : factors) {
+                BOOST_TEST_CONTEXT (
+                    "type " << type << ", " << size.width << "x"
+                    << size.height << ", factor " << factor) {
+                    const cv::Size to = bs::detail::scaled_size (frame, factor);
+
+                    cv::Mat dst, expected;
+
+                    bs::detail::area_resize (frame, dst, to);
+                    cv::resize (frame, expected, to, 0, 0, cv::INTER_AREA);
+
+                    BOOST_TEST (close (dst, expected));
+
+                    cv::Mat src = frame;
+                    const cv::Mat resized = bs::resize_frame (src, factor);
+
+                    BOOST_TEST (close (resized, expected));
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (gray) {
+    for (int type : { CV_8UC1, CV_8UC3 }) {
+        for (const auto& size : sizes) {
+            const cv::Mat frame = make_frame (size, type);
+
+            cv::Mat bw = frame;
+
+            if (CV_8UC3 == type)
+                cv::cvtColor (frame, bw, cv::COLOR_BGR2GRAY);
+
+            for (double factor : factors) {
+                BOOST_TEST_CONTEXT (
+                    "type " << type << ", " << size.width << "x"
+                    << size.height << ", factor " << factor) {
+                    const cv::Size to = bs::detail::scaled_size (frame, factor);
+
+                    cv::Mat dst, expected;
+
+                    bs::detail::area_gray (frame, dst, to);
+                    cv::resize (bw, expected, to, 0, 0, cv::INTER_AREA);
+
+                    BOOST_TEST (close (dst, expected));
+                }
+            }
+        }
+    }
+}
+
+//
+// A gray frame scaled to a width, the tiny frame of the models:
+//
+BOOST_AUTO_TEST_CASE (scale_frame) {
+    cv::Mat frame = make_frame (cv::Size (641, 479), CV_8UC3);
+
+    cv::Mat bw, expected;
+    cv::cvtColor (frame, bw, cv::COLOR_BGR2GRAY);
+
+    const cv::Mat tiny = bs::scale_frame (frame, 199);
+
+    cv::resize (bw, expected, tiny.size (), 0, 0, cv::INTER_AREA);
+
+    BOOST_TEST (199 == tiny.cols);
+    BOOST_TEST (close (tiny, expected));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
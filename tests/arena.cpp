@@ -0,0 +1,65 @@
+// -*- mode: c++ -*-
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE arena
+
+#include <bs/arena.hpp>
+#include <bs/utils.hpp>
+
+#include <boost/test/unit_test.hpp>
+namespace utf = boost::unit_test;
+
+BOOST_AUTO_TEST_SUITE(arena)
+
+BOOST_AUTO_TEST_CASE (steady_state) {
+    bs::arena_t arena;
+
+    {
+        bs::arena_scope_t scope (arena);
+
+        const cv::Mat a (480, 640, CV_8UC3, cv::Scalar (1, 2, 3));
+        const cv::Mat b (480, 640, CV_8UC3, cv::Scalar (3, 2, 1));
+
+        bs::arena_t::counters_t before { };
+
+        for (size_t i = 0; i < 8; ++i) {
+            if (2 == i)
+                before = arena.counters ();
+
+            const cv::Mat d = bs::absdiff (a, b);
+            const cv::Mat g = bs::mono_from (bs::float_from (d));
+
+            BOOST_TEST (2 == g.at< cv::Vec3b > (0, 0) [0]);
+        }
+
+        const auto delta = arena.counters () - before;
+
+        BOOST_TEST (0 == delta.misses);
+        BOOST_TEST (0 == delta.header_misses);
+        BOOST_TEST (delta.allocations == delta.deallocations);
+        BOOST_TEST (0 < delta.allocations);
+        BOOST_TEST (delta.allocations <= delta.headers);
+    }
+
+    BOOST_TEST (cv::Mat::getDefaultAllocator () != &arena);
+}
+
+BOOST_AUTO_TEST_CASE (large_blocks) {
+    bs::arena_t arena;
+
+    {
+        bs::arena_scope_t scope (arena);
+        cv::Mat x (2160, 3840, CV_8UC3, cv::Scalar (0));
+    }
+
+    const size_t mapped = arena.counters ().mapped;
+    BOOST_TEST (3840UL * 2160 * 3 < mapped);
+
+    //
+    // The freed 4K frame goes back to the system, the slab of headers stays:
+    //
+    arena.trim ();
+    BOOST_TEST (arena.counters ().mapped + 3840UL * 2160 * 3 <= mapped);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
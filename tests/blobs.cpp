@@ -0,0 +1,85 @@
+// -*- mode: c++ -*-
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE blobs
+
+#include <bs/blobs.hpp>
+
+#include <boost/test/unit_test.hpp>
+namespace tt = boost::test_tools;
+
+#include <algorithm>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(components)
+
+static cv::Mat
+make_mask () {
+    cv::Mat x (8, 10, CV_8U, cv::Scalar (0));
+
+    //
+    // An L-shaped blob, a diagonal pair and a single pixel:
+    //
+    x (cv::Rect (1, 1, 1, 4)) = 255;
+    x (cv::Rect (1, 4, 4, 1)) = 255;
+
+    x.at< unsigned char > (1, 7) = 255;
+    x.at< unsigned char > (2, 8) = 255;
+
+    x.at< unsigned char > (6, 8) = 255;
+
+    return x;
+}
+
+static std::vector< size_t >
+areas_of (const std::vector< bs::blob_t >& blobs) {
+    std::vector< size_t > areas;
+
+    for (const auto& blob : blobs)
+        areas.push_back (blob.area);
+
+    return std::sort (areas.begin (), areas.end ()), areas;
+}
+
+BOOST_AUTO_TEST_CASE (connectivity_test) {
+    const auto mask = make_mask ();
+
+    {
+        bs::blobs_t blobs (1, 100, 8);
+        BOOST_TEST ((areas_of (blobs (mask)) == std::vector< size_t > { 1, 2, 7 }));
+    }
+
+    {
+        bs::blobs_t blobs (1, 100, 4);
+        BOOST_TEST ((areas_of (blobs (mask)) == std::vector< size_t > { 1, 1, 1, 7 }));
+    }
+}
+
+BOOST_AUTO_TEST_CASE (statistics_test) {
+    bs::blobs_t blobs (3);
+
+    const auto& result = blobs (make_mask ());
+    BOOST_TEST (1 == result.size ());
+
+    const auto& blob = result.front ();
+
+    BOOST_TEST (1 == blob.bbox.x);
+    BOOST_TEST (1 == blob.bbox.y);
+    BOOST_TEST (4 == blob.bbox.width);
+    BOOST_TEST (4 == blob.bbox.height);
+
+    BOOST_TEST (7 == blob.area);
+    BOOST_TEST (blob.centroid.x == 13. / 7, tt::tolerance (1e-9));
+    BOOST_TEST (blob.centroid.y == 22. / 7, tt::tolerance (1e-9));
+}
+
+BOOST_AUTO_TEST_CASE (tiles_test) {
+    const auto mask = make_mask ();
+
+    for (size_t tiles = 1; tiles <= size_t (mask.rows); ++tiles) {
+        bs::blobs_t blobs (1, 100, 8, tiles);
+        BOOST_TEST ((areas_of (blobs (mask)) == std::vector< size_t > { 1, 2, 7 }));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,201 @@
+// -*- mode: c++ -*-
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE bootstrap
+
+#include <bs/adaptive_median.hpp>
+#include <bs/fgmm.hpp>
+#include <bs/fuzzy_choquet.hpp>
+#include <bs/fuzzy_sugeno.hpp>
+#include <bs/grimson_gmm.hpp>
+#include <bs/scene.hpp>
+#include <bs/sigma_delta.hpp>
+#include <bs/simple_gaussian.hpp>
+#include <bs/temporal_median.hpp>
+#include <bs/utils.hpp>
+#include <bs/zivkovic_gmm.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/imgproc.hpp>
+
+BOOST_AUTO_TEST_SUITE(bootstrap)
+
+//
+// A static scene, no sprites, no drift, no flicker, with or without sensor
+// noise; the same seed renders the same background in both:
+//
+static bs::scene_options_t
+static_options (int noise) {
+    bs::scene_options_t options;
+
+    options.size = cv::Size (96, 72);
+    options.sprites = 0;
+    options.drift = 0;
+    options.noise = noise;
+
+    return options;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+struct runner_t {
+    std::shared_ptr< bs::detail::base_t > model;
+    std::function< void (const std::vector< cv::Mat >&) > bootstrap;
+    std::function< void (const cv::Mat&) > update;
+};
+
+template< typename Model, typename ... Args >
+static runner_t
+runner_from (Args&& ... args) {
+    auto p = std::make_shared< Model > (std::forward< Args > (args)...);
+
+    return {
+        p,
+        [p](const std::vector< cv::Mat >& frames) { p->bootstrap (frames); },
+        [p](const cv::Mat& frame) { (*p) (frame); }
+    };
+}
+
+//
+// A model, started from a background that is all wrong (black) where it takes
+// one, and the conversion of the frames to its input and of the scene to its
+// background:
+//
+struct model_case_t {
+    std::string name;
+    std::function< cv::Mat (const cv::Mat&) > prepare, expected;
+    std::function< runner_t (const cv::Mat&) > make;
+};
+
+static cv::Mat
+as_is (const cv::Mat& frame) {
+    return frame;
+}
+
+static cv::Mat
+as_gray (const cv::Mat& frame) {
+    return bs::gray_from (frame);
+}
+
+static cv::Mat
+as_ycrcb (const cv::Mat& frame) {
+    return bs::float_from (bs::convert_color (frame, cv::COLOR_BGR2YCrCb));
+}
+
+static cv::Mat
+as_ohta (const cv::Mat& frame) {
+    return bs::float_from (bs::convert_ohta (frame));
+}
+
+static cv::Mat
+black (const cv::Mat& frame) {
+    return cv::Mat::zeros (frame.size (), frame.type ());
+}
+
+static const std::vector< model_case_t >&
+model_cases () {
+    static const std::vector< model_case_t > cases {
+        { "adaptive_median", as_gray, as_gray, [](const cv::Mat& x) {
+                return runner_from< bs::adaptive_median_t > (
+                    black (x), 10, 15); } },
+
+        { "fgmm_um", as_is, as_is, [](const cv::Mat&) {
+                return runner_from< bs::fgmm_um_t > (); } },
+
+        { "fgmm_uv", as_is, as_is, [](const cv::Mat&) {
+                return runner_from< bs::fgmm_uv_t > (); } },
+
+        { "fuzzy_choquet", as_is, as_ycrcb, [](const cv::Mat& x) {
+                return runner_from< bs::fuzzy_choquet_t > (
+                    bs::float_from (black (x))); } },
+
+        { "fuzzy_sugeno", as_is, as_ohta, [](const cv::Mat& x) {
+                return runner_from< bs::fuzzy_sugeno_t > (
+                    bs::float_from (black (x))); } },
+
+        { "grimson_gmm", as_is, as_is, [](const cv::Mat&) {
+                return runner_from< bs::grimson_gmm_t > (); } },
+
+        { "sigma_delta", as_gray, as_gray, [](const cv::Mat& x) {
+                return runner_from< bs::sigma_delta_t > (black (x)); } },
+
+        { "simple_gaussian", as_is, as_is, [](const cv::Mat& x) {
+                return runner_from< bs::simple_gaussian_t > (black (x)); } },
+
+        { "temporal_median", as_gray, as_gray, [](const cv::Mat& x) {
+                return runner_from< bs::temporal_median_t > (black (x)); } },
+
+        { "zivkovic_gmm", as_is, as_is, [](const cv::Mat&) {
+                return runner_from< bs::zivkovic_gmm_t > (); } }
+    };
+
+    return cases;
+}
+
+//
+// The largest error of a bootstrapped background, relative to its range, a few
+// levels of the sensor noise of the scene:
+//
+static const double tolerance = .02;
+
+static double
+range_of (const cv::Mat& x) {
+    switch (x.depth ()) {
+    case CV_8U:  return 255.;
+    case CV_16U: return 65535.;
+    default:
+        return 1.;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// Bootstrapped from the frames of a static scene, the background of a model is
+// the scene, and the next frame has (almost) no foreground:
+//
+BOOST_AUTO_TEST_CASE (static_scene) {
+    const auto frames = bs::scene_t (static_options (2)).frames (16);
+
+    cv::Mat scene, mask;
+    bs::scene_t (static_options (0)).render (0, scene, mask);
+
+    for (const auto& c : model_cases ()) {
+        BOOST_TEST_CONTEXT (c.name) {
+            std::vector< cv::Mat > xs;
+
+            for (const auto& frame : frames)
+                xs.push_back (c.prepare (frame));
+
+            const cv::Mat last = xs.back ();
+            xs.pop_back ();
+
+            runner_t runner = c.make (xs [0]);
+            runner.bootstrap (xs);
+
+            const cv::Mat& background = runner.model->background ();
+            const cv::Mat expected = c.expected (scene);
+
+            BOOST_TEST_REQUIRE (
+                (background.size () == expected.size () &&
+                 background.type () == expected.type ()));
+
+            BOOST_TEST (
+                cv::norm (background, expected, cv::NORM_INF)
+                / range_of (expected) <= tolerance);
+
+            runner.update (last);
+
+            const cv::Mat& m = runner.model->mask ();
+            BOOST_TEST (cv::countNonZero (m) <= int (m.total () / 100));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
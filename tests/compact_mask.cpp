@@ -0,0 +1,165 @@
+// -*- mode: c++ -*-
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE compact_mask
+
+#include <bs/compact_mask.hpp>
+#include <bs/scene.hpp>
+#include <bs/sigma_delta.hpp>
+#include <bs/utils.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(compact_mask)
+
+static bool
+equal (const cv::Mat& a, const cv::Mat& b) {
+    return a.size () == b.size () && a.type () == b.type () &&
+        0. == cv::norm (a, b, cv::NORM_INF);
+}
+
+//
+// The mask as decoded, 255 where the source is non-zero:
+//
+static cv::Mat
+normalized (const cv::Mat& m) {
+    return m != 0;
+}
+
+//
+// A mask with an empty first row, a full last one, and in between random runs
+// and runs across the boundaries of the packed words:
+//
+static cv::Mat
+make_mask (int rows, int cols, unsigned seed) {
+    cv::Mat m (rows, cols, CV_8U, cv::Scalar (0));
+
+    cv::RNG rng (seed);
+
+    for (int i = 1; i < rows - 1; ++i) {
+        unsigned char* p = m.ptr< unsigned char > (i);
+
+        if (i % 3 == 0) {
+            for (int k = 64; k <= cols; k += 64) {
+                const int first = (std::max) (k - 1 - i % 5, 0);
+                const int last = (std::min) (k + 1 + i % 7, cols);
+
+                std::fill (p + first, p + last, 255);
+            }
+        }
+        else {
+            for (int j = 0; j < cols; ) {
+                const int n = rng.uniform (1, 80);
+                const unsigned char value =
+                    rng.uniform (0, 2) ? 1 + i % 255 : 0;
+
+                std::fill (p + j, p + (std::min) (j + n, cols), value);
+                j += n;
+            }
+        }
+    }
+
+    m.row (rows - 1).setTo (cv::Scalar (255));
+
+    return m;
+}
+
+static const int widths [] = { 1, 7, 63, 64, 65, 100, 127, 128, 129, 200 };
+
+BOOST_AUTO_TEST_CASE (packed) {
+    for (int cols : widths) {
+        BOOST_TEST_CONTEXT ("width " << cols) {
+            const cv::Mat m = make_mask (11, cols, cols);
+
+            bs::packed_mask_t p;
+            bs::pack (m, p);
+
+            BOOST_TEST (p.rows == m.rows);
+            BOOST_TEST (p.cols == m.cols);
+            BOOST_TEST (p.stride == size_t (cols + 63) / 64);
+
+            //
+            // The bits past the last column are zero:
+            //
+            if (cols % 64) {
+                const uint64_t tail = ~uint64_t (0) << (cols % 64);
+
+                for (int i = 0; i < p.rows; ++i)
+                    BOOST_TEST (0 == (p.row (i) [p.stride - 1] & tail));
+            }
+
+            BOOST_TEST (equal (bs::unpack (p), normalized (m)));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (rle) {
+    for (int cols : widths) {
+        BOOST_TEST_CONTEXT ("width " << cols) {
+            const cv::Mat m = make_mask (11, cols, cols);
+
+            bs::rle_mask_t r, s;
+            bs::encode (m, r);
+
+            BOOST_TEST (r.rows == m.rows);
+            BOOST_TEST (r.cols == m.cols);
+            BOOST_TEST_REQUIRE (r.offsets.size () == size_t (m.rows + 1));
+
+            //
+            // No spans in the empty row, one over the whole full row:
+            //
+            BOOST_TEST (r.offsets [0] == r.offsets [1]);
+            BOOST_TEST (1 == r.offsets [m.rows] - r.offsets [m.rows - 1]);
+
+            BOOST_TEST (equal (bs::decode (r), normalized (m)));
+
+            //
+            // The same spans from the packed mask:
+            //
+            bs::packed_mask_t p;
+            bs::pack (m, p);
+            bs::encode (p, s);
+
+            BOOST_TEST (
+                r.offsets == s.offsets, boost::test_tools::per_element ());
+            BOOST_TEST_REQUIRE (r.spans.size () == s.spans.size ());
+
+            for (size_t k = 0; k < r.spans.size (); ++k) {
+                BOOST_TEST (r.spans [k].begin == s.spans [k].begin);
+                BOOST_TEST (r.spans [k].end == s.spans [k].end);
+            }
+        }
+    }
+}
+
+//
+// The compact masks a model emits along with its mask:
+//
+BOOST_AUTO_TEST_CASE (emitted) {
+    bs::scene_options_t options;
+
+    options.size = cv::Size (100, 40);
+    options.sprites = 3;
+
+    const auto frames = bs::scene_t (options).frames (12);
+
+    bs::sigma_delta_t model (bs::gray_from (frames [0]));
+    model.mask_format (bs::MASK_PACKED | bs::MASK_RLE);
+
+    size_t foreground = 0;
+
+    for (const auto& frame : frames) {
+        const cv::Mat& mask = model (bs::gray_from (frame));
+
+        foreground += cv::countNonZero (mask);
+
+        BOOST_TEST (equal (bs::unpack (model.packed_mask ()), mask));
+        BOOST_TEST (equal (bs::decode (model.rle_mask ()), mask));
+    }
+
+    BOOST_TEST (0 < foreground);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,97 @@
+// -*- mode: c++ -*-
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE decay
+
+#include <bs/detail/decay.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(decay)
+
+//
+// The weights of a pixel of three modes, matched in turn, updated as the
+// Zivkovic mixture does, with a bias against the modes not matched: lazily,
+// un-normalized, over many epochs of a small scale limit, and eagerly,
+// normalized on every frame. The pixel loses weight to the bias, its sum
+// falls behind the scale of the epochs:
+//
+BOOST_AUTO_TEST_CASE (bias) {
+    const double alpha = .05, bias = .05;
+    const size_t n = 3, frames = 200000;
+
+    bs::detail::lazy_decay_t decay (alpha, 1e4);
+
+    auto stamp = decay.stamp ();
+
+    std::vector< double > w (n, 1. / n), p (w);
+
+    bool finite = true, normalized = true, close = true;
+    size_t epochs = 0;
+
+    for (size_t t = 0; t < frames; ++t) {
+        decay.advance ();
+
+        const double factor = decay.rebase (stamp);
+
+        if (1. != factor) {
+            for (auto& x : w)
+                x *= factor;
+
+            stamp.total = std::accumulate (w.begin (), w.end (), 0.);
+            ++epochs;
+        }
+
+        const double increment = decay.increment (stamp);
+        const double b = alpha * bias * (stamp.total + increment);
+
+        double total = stamp.total + increment;
+
+        //
+        // The same in normalized units:
+        //
+        const double r = alpha / (1 - alpha), c = alpha * bias * (1 + r);
+        double sum = 1 + r;
+
+        for (size_t j = 0; j < n; ++j) {
+            if (j == t % n) {
+                w [j] += increment;
+                p [j] += r;
+            }
+            else {
+                w [j] -= b;
+                total -= b;
+
+                p [j] -= c;
+                sum -= c;
+            }
+        }
+
+        for (auto& x : p)
+            x /= sum;
+
+        stamp.total = total;
+
+        finite = finite && std::isfinite (total) && total > 0;
+
+        const double s = std::accumulate (w.begin (), w.end (), 0.);
+        normalized = normalized && std::abs (s / total - 1) < 1e-9;
+
+        for (size_t j = 0; j < n; ++j) {
+            finite = finite && std::isfinite (w [j]);
+            close = close && std::abs (w [j] / total - p [j]) < 1e-9;
+        }
+    }
+
+    BOOST_TEST (100 < epochs);
+
+    BOOST_TEST (finite);
+    BOOST_TEST (normalized);
+    BOOST_TEST (close);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,184 @@
+// -*- mode: c++ -*-
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE ewma
+
+#include <bs/ewma.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(ewma)
+
+static const int depths [] = { CV_8U, CV_16U, CV_32F };
+
+static double
+range_of (int depth) {
+    switch (depth) {
+    case CV_8U:  return 256.;
+    case CV_16U: return 65536.;
+    default:
+        return 1.;
+    }
+}
+
+//
+// Random frames of odd size, three channels, over the whole range of the
+// depth:
+//
+static std::vector< cv::Mat >
+make_frames (int depth, size_t n) {
+    std::vector< cv::Mat > frames;
+
+    cv::RNG rng (depth + 1);
+
+    for (size_t i = 0; i < n; ++i) {
+        cv::Mat frame (29, 37, CV_MAKETYPE (depth, 3));
+        rng.fill (frame, cv::RNG::UNIFORM, 0., range_of (depth));
+
+        frames.push_back (frame);
+    }
+
+    return frames;
+}
+
+static std::vector< cv::Mat >
+doubles_from (const std::vector< cv::Mat >& frames) {
+    std::vector< cv::Mat > xs (frames.size ());
+
+    for (size_t i = 0; i < frames.size (); ++i)
+        frames [i].convertTo (xs [i], CV_64FC3);
+
+    return xs;
+}
+
+//
+// Rounding of integer results, within a level, or float error, within a small
+// fraction of the range of the frames:
+//
+static bool
+close (const cv::Mat& value, const cv::Mat& expected, int type, int depth) {
+    if (value.size () != expected.size () || value.type () != type)
+        return false;
+
+    cv::Mat x;
+    expected.convertTo (x, type);
+
+    const double error = CV_32F == CV_MAT_DEPTH (type)
+        ? 1e-4 * range_of (depth) : 1.;
+
+    return cv::norm (value, x, cv::NORM_INF) <= error;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE (ewma) {
+    const double alpha = .25;
+
+    for (int depth : depths) {
+        BOOST_TEST_CONTEXT ("depth " << depth) {
+            const auto frames = make_frames (depth, 6);
+            const auto xs = doubles_from (frames);
+
+            bs::ewma_t f (alpha), g (alpha, CV_32F);
+
+            cv::Mat s = xs [0].clone ();
+
+            for (size_t i = 0; i < frames.size (); ++i) {
+                if (i)
+                    s = s * (1 - alpha) + xs [i] * alpha;
+
+                f (frames [i]);
+                g (frames [i]);
+
+                BOOST_TEST (f.size () == i + 1);
+                BOOST_TEST (close (f.value (), s, frames [i].type (), depth));
+                BOOST_TEST (close (g.value (), s, CV_32FC3, depth));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (window_mean) {
+    for (int depth : depths) {
+        BOOST_TEST_CONTEXT ("depth " << depth) {
+            const auto frames = make_frames (depth, 7);
+            const auto xs = doubles_from (frames);
+
+            bs::window_mean_t f, g (3), h (3, CV_32F);
+
+            for (size_t i = 0; i < frames.size (); ++i) {
+                f (frames [i]);
+                g (frames [i]);
+                h (frames [i]);
+
+                //
+                // The mean of all frames, and of the last three:
+                //
+                cv::Mat all = cv::Mat::zeros (xs [0].size (), xs [0].type ());
+                cv::Mat last = all.clone ();
+
+                for (size_t k = 0; k <= i; ++k) {
+                    all += xs [k];
+
+                    if (i - k < 3)
+                        last += xs [k];
+                }
+
+                all /= double (i + 1);
+                last /= double ((std::min) (i + 1, size_t (3)));
+
+                const int type = frames [i].type ();
+
+                BOOST_TEST (close (f.value (), all, type, depth));
+                BOOST_TEST (close (g.value (), last, type, depth));
+                BOOST_TEST (close (h.value (), last, CV_32FC3, depth));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (window_median) {
+    for (int depth : depths) {
+        BOOST_TEST_CONTEXT ("depth " << depth) {
+            const auto frames = make_frames (depth, 8);
+            const auto xs = doubles_from (frames);
+
+            bs::window_median_t f (5), g (5, CV_32F);
+
+            for (size_t i = 0; i < frames.size (); ++i) {
+                f (frames [i]);
+                g (frames [i]);
+
+                //
+                // The upper median of the last five frames:
+                //
+                const size_t first = i < 5 ? 0 : i - 4, n = i + 1 - first;
+
+                cv::Mat median (xs [0].size (), xs [0].type ());
+                std::vector< double > buf (n);
+
+                for (int r = 0; r < median.rows; ++r) {
+                    for (int j = 0; j < median.cols * 3; ++j) {
+                        for (size_t k = 0; k < n; ++k)
+                            buf [k] = xs [first + k].ptr< double > (r) [j];
+
+                        std::nth_element (
+                            buf.begin (), buf.begin () + n / 2, buf.end ());
+
+                        median.ptr< double > (r) [j] = buf [n / 2];
+                    }
+                }
+
+                const int type = frames [i].type ();
+
+                BOOST_TEST (close (f.value (), median, type, depth));
+                BOOST_TEST (close (g.value (), median, CV_32FC3, depth));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
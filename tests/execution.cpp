@@ -0,0 +1,90 @@
+// -*- mode: c++ -*-
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE execution
+
+#include <bs/execution.hpp>
+#include <bs/sigma_delta.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#if defined (__linux__)
+#  include <sched.h>
+#endif // __linux__
+
+BOOST_AUTO_TEST_SUITE(execution)
+
+#if defined (__linux__)
+
+//
+// The cores the calling thread may run on:
+//
+static std::vector< int >
+affinity () {
+    cpu_set_t set;
+    CPU_ZERO (&set);
+
+    BOOST_TEST_REQUIRE (0 == sched_getaffinity (0, sizeof set, &set));
+
+    std::vector< int > cores;
+
+    for (int i = 0; i < CPU_SETSIZE; ++i)
+        if (CPU_ISSET (i, &set))
+            cores.push_back (i);
+
+    return cores;
+}
+
+BOOST_AUTO_TEST_CASE (restore) {
+    const auto before = affinity ();
+    BOOST_TEST_REQUIRE (!before.empty ());
+
+    //
+    // Two contexts with the same cores, but different objects, and a context
+    // without cores; the caller gets its own affinity back after each:
+    //
+    const int core = before.back ();
+
+    const bs::execution_t a { 1, { core }, -1, bs::execution_t::PIN };
+    const bs::execution_t b { 1, { core }, -1, bs::execution_t::FLOAT };
+
+    for (const auto& x : { a, b, bs::execution_t { } }) {
+        {
+            const bs::execution_scope_t scope (x);
+
+            if (!x.cores.empty ())
+                BOOST_TEST (affinity () == std::vector< int > { core });
+            else
+                BOOST_TEST (affinity () == before);
+        }
+
+        BOOST_TEST (affinity () == before);
+    }
+}
+
+#endif // __linux__
+
+BOOST_AUTO_TEST_CASE (resolved) {
+    bs::execution_t x;
+    x.node = 0;
+
+    const auto cores = bs::execution_t::node_cores (0);
+
+    BOOST_TEST (x.resolved ().cores == cores);
+    BOOST_TEST (x.resolved ().node == 0);
+
+    //
+    // A model resolves the cores of the node when it is given the context:
+    //
+    const cv::Mat b (8, 8, CV_8U, cv::Scalar (0));
+    bs::sigma_delta_t model (b, 2, 2, 255, x);
+
+    BOOST_TEST (model.execution ().cores == cores);
+
+    x.cores = { 0 };
+    BOOST_TEST (x.resolved ().cores == std::vector< int > { 0 });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,181 @@
+// -*- mode: c++ -*-
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE fuzzy_integral
+
+#include <bs/utils.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+using namespace std;
+
+#include "fuzzy_integral.hpp"
+
+BOOST_AUTO_TEST_SUITE(fuzzy_integral)
+
+//
+// Criteria in [0, 1], drawn from a few levels for ties to be frequent:
+//
+static std::vector< cv::Mat >
+make_criteria (int n, unsigned seed) {
+    std::mt19937 gen (seed);
+    std::uniform_int_distribution< int > dist (0, 4);
+
+    std::vector< cv::Mat > xs;
+
+    for (int k = 0; k < n; ++k) {
+        cv::Mat x (13, 67, CV_32F);
+
+        for (size_t i = 0; i < x.total (); ++i)
+            x.at< float > (i) = dist (gen) / 4.f;
+
+        xs.push_back (x);
+    }
+
+    return xs;
+}
+
+//
+// Densities summing to 1:
+//
+static std::vector< double >
+make_densities (int n, unsigned seed) {
+    std::mt19937 gen (seed);
+    std::uniform_real_distribution< double > dist (.1, 1.);
+
+    std::vector< double > g (n);
+
+    for (auto& x : g)
+        x = dist (gen);
+
+    const double sum = std::accumulate (g.begin (), g.end (), 0.);
+
+    for (auto& x : g)
+        x /= sum;
+
+    return g;
+}
+
+//
+// The criteria of a pixel ranked by decreasing value, ties by index:
+//
+static std::vector< int >
+ranking (const std::vector< float >& h) {
+    std::vector< int > order (h.size ());
+    std::iota (order.begin (), order.end (), 0);
+
+    std::stable_sort (order.begin (), order.end (), [&](int a, int b) {
+        return h [a] > h [b];
+    });
+
+    return order;
+}
+
+//
+// The Choquet integral over the sorted criteria, the sum of the increments of
+// the values weighted by the measures of the sets of the criteria at or above
+// them:
+//
+static float
+choquet (const std::vector< float >& h, const std::vector< double >& g) {
+    const auto order = ranking (h);
+
+    double s = 0, measure = 0;
+
+    for (size_t r = 0; r < order.size (); ++r) {
+        measure += g [order [r]];
+
+        const double next = r + 1 < order.size () ? h [order [r + 1]] : 0.;
+        s += (h [order [r]] - next) * measure;
+    }
+
+    return float (s);
+}
+
+//
+// The Sugeno integral over the sorted criteria; the set of a criterion is the
+// one of the criteria ranked at or after it, the set of the first measures 1:
+//
+static float
+sugeno (const std::vector< float >& h, const std::vector< double >& g) {
+    const auto order = ranking (h);
+
+    float s = 0, measure = 0;
+
+    for (size_t r = order.size (); r-- > 0; ) {
+        measure += float (g [order [r]]);
+
+        const float m = r ? measure : 1.f;
+        s = (std::max) (s, (std::min) (h [order [r]], m));
+    }
+
+    return s;
+}
+
+template< typename F >
+static cv::Mat
+reference (const std::vector< cv::Mat >& xs, const std::vector< double >& g,
+           F f) {
+    cv::Mat dst (xs [0].size (), CV_32F);
+    std::vector< float > h (xs.size ());
+
+    for (size_t i = 0; i < dst.total (); ++i) {
+        for (size_t k = 0; k < xs.size (); ++k)
+            h [k] = xs [k].at< float > (i);
+
+        dst.at< float > (i) = f (h, g);
+    }
+
+    return dst;
+}
+
+static bool
+close (const cv::Mat& a, const cv::Mat& b) {
+    return a.size () == b.size () && a.type () == b.type () &&
+        cv::norm (a, b, cv::NORM_INF) <= 1e-5;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// Three criteria, the texture plane and the first two channels of the color
+// similarity, as the models pass them to the row kernels:
+//
+BOOST_AUTO_TEST_CASE (three) {
+    const auto xs = make_criteria (3, 1);
+    const auto g = make_densities (3, 2);
+
+    cv::Mat I;
+    cv::merge (std::vector< cv::Mat > {
+            xs [1], xs [2], cv::Mat::zeros (xs [0].size (), CV_32F) }, I);
+
+    const cv::Mat choquet_n = choquet_integral (xs, g);
+    const cv::Mat sugeno_n = sugeno_integral (xs, g);
+
+    BOOST_TEST (close (choquet_n, choquet_integral (xs [0], I, g)));
+    BOOST_TEST (close (sugeno_n, sugeno_integral (xs [0], I, g)));
+
+    BOOST_TEST (close (choquet_n, reference (xs, g, choquet)));
+    BOOST_TEST (close (sugeno_n, reference (xs, g, sugeno)));
+}
+
+BOOST_AUTO_TEST_CASE (many) {
+    for (int n : { 1, 2, 4, 5, 7 }) {
+        BOOST_TEST_CONTEXT (n << " criteria") {
+            const auto xs = make_criteria (n, 3 + n);
+            const auto g = make_densities (n, 4 + n);
+
+            BOOST_TEST (close (
+                choquet_integral (xs, g), reference (xs, g, choquet)));
+
+            BOOST_TEST (close (
+                sugeno_integral (xs, g), reference (xs, g, sugeno)));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
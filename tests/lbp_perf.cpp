@@ -1,6 +1,7 @@
 // -*- mode: c++; -*-
 
 #include <iostream>
+#include <map>
 using namespace std;
 
 #include <opencv2/core.hpp>
@@ -10,6 +11,8 @@ using namespace cv;
 using namespace benchmark;
 
 #include <bs/detail/lbp.hpp>
+#include <bs/scene.hpp>
+#include <bs/utils.hpp>
 
 ////////////////////////////////////////////////////////////////////////
 
@@ -61,9 +64,31 @@ f (const cv::Mat& src)
     return dst;
 }
 
+//
+// A gray frame of a synthetic scene, the same for all runs of a size:
+//
+static Mat
+frame_of (int n) {
+    static std::map< int, Mat > frames;
+
+    auto& frame = frames [n];
+
+    if (frame.empty ()) {
+        bs::scene_options_t options;
+
+        options.size = Size (n, n);
+        options.type = CV_8UC1;
+
+        Mat mask;
+        bs::scene_t (options).render (0, frame, mask);
+    }
+
+    return frame;
+}
+
 static void
 BM_ref (benchmark::State& state) {
-    Mat src (state.range (0), state.range (0), CV_8U);
+    const Mat src = frame_of (state.range (0));
 
     while (state.KeepRunning ()) {
         DoNotOptimize (f (src));
@@ -74,16 +99,43 @@ BM_ref (benchmark::State& state) {
 
 static void
 BM_lbp (benchmark::State& state) {
-    Mat src (state.range (0), state.range (0), CV_8U);
+    const Mat src = frame_of (state.range (0));
 
     while (state.KeepRunning ()) {
         DoNotOptimize (bs::lbp (src));
     }
 };
 
+////////////////////////////////////////////////////////////////////////
+
+//
+// The generator itself, which must not bottleneck the benchmarks that use it:
+//
+static void
+BM_scene (benchmark::State& state) {
+    bs::scene_options_t options;
+
+    options.size = Size (state.range (0), state.range (0) * 9 / 16);
+    options.flicker = options.waving = 2;
+
+    const bs::scene_t scene (options);
+
+    Mat frame, mask;
+    size_t t = 0;
+
+    while (state.KeepRunning ()) {
+        scene.render (t++, frame, mask);
+        DoNotOptimize (frame.data);
+    }
+
+    state.SetBytesProcessed (
+        int64_t (state.iterations ()) * frame.total () * frame.elemSize ());
+};
+
 int main (int argc, char** argv) {
     RegisterBenchmark ("BM_lbp", &BM_lbp)->RangeMultiplier(2)->Range(128, 16384);
     RegisterBenchmark ("BM_ref", &BM_ref)->RangeMultiplier(2)->Range(128, 16384);
+    RegisterBenchmark ("BM_scene", &BM_scene)->RangeMultiplier(2)->Range(256, 4096);
 
     Initialize (&argc, argv);
     RunSpecifiedBenchmarks ();
@@ -0,0 +1,245 @@
+// -*- mode: c++ -*-
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE morphology
+
+#include <bs/execution.hpp>
+#include <bs/morphology.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(morphology)
+
+//
+// Random masks, wider than a word, with a partial last word:
+//
+static cv::Mat
+make_mask (int rows, int cols, double density, unsigned seed) {
+    std::mt19937 gen (seed);
+    std::bernoulli_distribution dist (density);
+
+    cv::Mat x (rows, cols, CV_8U, cv::Scalar (0));
+
+    for (size_t i = 0; i < x.total (); ++i)
+        x.at< unsigned char > (i) = dist (gen) ? 255 : 0;
+
+    return x;
+}
+
+//
+// Counts the foreground pixels of the 3x3 window, and the pixels of the window
+// that are outside the mask:
+//
+static std::pair< int, int >
+window_of (const cv::Mat& src, int i, int j) {
+    int count = 0, outside = 0;
+
+    for (int y = i - 1; y <= i + 1; ++y) {
+        for (int x = j - 1; x <= j + 1; ++x) {
+            if (y < 0 || y >= src.rows || x < 0 || x >= src.cols)
+                ++outside;
+            else
+                count += 0 != src.at< unsigned char > (y, x);
+        }
+    }
+
+    return { count, outside };
+}
+
+template< typename F >
+static cv::Mat
+reference (const cv::Mat& src, F f) {
+    cv::Mat dst (src.size (), CV_8U);
+
+    for (int i = 0; i < src.rows; ++i) {
+        for (int j = 0; j < src.cols; ++j) {
+            const auto w = window_of (src, i, j);
+            dst.at< unsigned char > (i, j) = f (w.first, w.second) ? 255 : 0;
+        }
+    }
+
+    return dst;
+}
+
+static cv::Mat
+apply (void (*op) (const bs::packed_mask_t&, bs::packed_mask_t&),
+       const cv::Mat& src) {
+    bs::packed_mask_t x, y;
+
+    bs::pack (src, x);
+    op (x, y);
+
+    return bs::unpack (y);
+}
+
+static bool
+equal (const cv::Mat& lhs, const cv::Mat& rhs) {
+    for (size_t i = 0; i < lhs.total (); ++i)
+        if (lhs.at< unsigned char > (i) != rhs.at< unsigned char > (i))
+            return false;
+
+    return true;
+}
+
+BOOST_AUTO_TEST_CASE (filter_test) {
+    for (int cols : { 1, 63, 64, 65, 130 }) {
+        const auto src = make_mask (7, cols, .6, cols);
+
+        BOOST_TEST (equal (apply (bs::erode, src), reference (
+            src, [](int n, int outside) { return 9 == n + outside; })));
+
+        BOOST_TEST (equal (apply (bs::dilate, src), reference (
+            src, [](int n, int) { return n > 0; })));
+
+        BOOST_TEST (equal (apply (bs::majority, src), reference (
+            src, [](int n, int) { return n >= 5; })));
+    }
+}
+
+BOOST_AUTO_TEST_CASE (reconstruct_test) {
+    //
+    // A snake-like region, reached from a single seed only through its turns:
+    //
+    cv::Mat lo (5, 140, CV_8U, cv::Scalar (0)), hi = lo.clone ();
+
+    lo (cv::Rect (0, 0, 140, 1)) = 255;
+    lo.at< unsigned char > (1, 139) = 255;
+    lo (cv::Rect (0, 2, 140, 1)) = 255;
+    lo.at< unsigned char > (3, 0) = 255;
+    lo (cv::Rect (1, 4, 100, 1)) = 255;
+
+    //
+    // A region without seeds, and the seed:
+    //
+    lo (cv::Rect (120, 4, 10, 1)) = 255;
+    hi.at< unsigned char > (0, 5) = 255;
+
+    bs::packed_mask_t seeds, mask, dst;
+
+    bs::pack (hi, seeds);
+    bs::pack (lo, mask);
+
+    bs::reconstruct (seeds, mask, dst, 8);
+
+    {
+        auto expected = lo.clone ();
+        expected (cv::Rect (120, 4, 10, 1)) = 0;
+
+        BOOST_TEST (equal (bs::unpack (dst), expected));
+    }
+
+    //
+    // The last run connects only diagonally:
+    //
+    bs::reconstruct (seeds, mask, dst, 4);
+
+    {
+        auto expected = lo.clone ();
+        expected (cv::Rect (0, 4, 140, 1)) = 0;
+
+        BOOST_TEST (equal (bs::unpack (dst), expected));
+    }
+}
+
+//
+// The pixels of lo connected to a pixel of hi, by a flood fill:
+//
+static cv::Mat
+flood (const cv::Mat& hi, const cv::Mat& lo, int connectivity) {
+    cv::Mat dst (lo.size (), CV_8U, cv::Scalar (0));
+    std::vector< std::pair< int, int > > stack;
+
+    for (int i = 0; i < lo.rows; ++i)
+        for (int j = 0; j < lo.cols; ++j)
+            if (hi.at< unsigned char > (i, j) && lo.at< unsigned char > (i, j))
+                stack.emplace_back (i, j);
+
+    while (!stack.empty ()) {
+        const auto p = stack.back ();
+        stack.pop_back ();
+
+        if (dst.at< unsigned char > (p.first, p.second))
+            continue;
+
+        dst.at< unsigned char > (p.first, p.second) = 255;
+
+        for (int y = p.first - 1; y <= p.first + 1; ++y) {
+            for (int x = p.second - 1; x <= p.second + 1; ++x) {
+                if (y < 0 || y >= lo.rows || x < 0 || x >= lo.cols)
+                    continue;
+
+                if (4 == connectivity && y != p.first && x != p.second)
+                    continue;
+
+                if (lo.at< unsigned char > (y, x))
+                    stack.emplace_back (y, x);
+            }
+        }
+    }
+
+    return dst;
+}
+
+//
+// Reconstructed in bands, one per thread, and merged across the seams; the
+// first region snakes up and down through all the bands:
+//
+BOOST_AUTO_TEST_CASE (reconstruct_bands_test) {
+    cv::Mat lo (96, 70, CV_8U, cv::Scalar (0)), hi = lo.clone ();
+
+    for (int j = 0; j < lo.cols; j += 2) {
+        lo.col (j) = 255;
+
+        if (j + 2 < lo.cols)
+            lo.at< unsigned char > ((j / 2) % 2 ? 0 : lo.rows - 1, j + 1) = 255;
+    }
+
+    hi.at< unsigned char > (0, 0) = 255;
+
+    const std::pair< cv::Mat, cv::Mat > cases [] = {
+        { hi, lo },
+        { make_mask (96, 70, .05, 3), make_mask (96, 70, .55, 4) },
+        { make_mask (200, 130, .01, 5), make_mask (200, 130, .5, 6) }
+    };
+
+    for (size_t threads : { 1, 2, 3, 4 }) {
+        bs::execution_t x;
+        x.threads = threads;
+
+        const bs::execution_scope_t scope (x);
+
+        for (const auto& c : cases) {
+            bs::packed_mask_t seeds, mask, dst;
+
+            bs::pack (c.first, seeds);
+            bs::pack (c.second, mask);
+
+            for (int connectivity : { 4, 8 }) {
+                BOOST_TEST_CONTEXT (
+                    threads << " threads, " << c.first.rows << " rows, "
+                    << connectivity << "-connected") {
+                    bs::reconstruct (seeds, mask, dst, connectivity);
+
+                    BOOST_TEST (equal (
+                        bs::unpack (dst),
+                        flood (c.first, c.second, connectivity)));
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE (chain_test) {
+    const auto src = make_mask (9, 70, .5, 1);
+
+    bs::morphology_t cleanup { bs::morphology_t::OPEN };
+
+    const auto opened = apply (bs::dilate, apply (bs::erode, src));
+    BOOST_TEST (equal (cleanup (src), opened));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
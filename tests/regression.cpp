@@ -0,0 +1,437 @@
+// -*- mode: c++ -*-
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE regression
+
+#include <bs/adaptive_median.hpp>
+#include <bs/cpu.hpp>
+#include <bs/detail/lbp.hpp>
+#include <bs/fgmm.hpp>
+#include <bs/fuzzy_choquet.hpp>
+#include <bs/fuzzy_sugeno.hpp>
+#include <bs/grimson_gmm.hpp>
+#include <bs/scene.hpp>
+#include <bs/sigma_delta.hpp>
+#include <bs/simple_gaussian.hpp>
+#include <bs/temporal_median.hpp>
+#include <bs/utils.hpp>
+#include <bs/zivkovic_gmm.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <sys/stat.h>
+
+//
+// The outputs of the models on a synthetic sequence, checked against golden
+// fixtures (PNG, under tests/fixtures), recorded from the scalar code of the
+// original models: on the host tier, on every tier the host has, and on one
+// thread. A missing fixture is a failure; BS_RECORD_FIXTURES=1 records them
+// anew, from the code under test, after a deliberate change of the outputs.
+//
+#ifndef BS_FIXTURES_DIR
+#  define BS_FIXTURES_DIR "fixtures"
+#endif // BS_FIXTURES_DIR
+
+BOOST_AUTO_TEST_SUITE(regression)
+
+//
+// A small synthetic scene, moving sprites over a background with a flickering
+// and a waving region:
+//
+static std::vector< cv::Mat >
+make_sequence (size_t n) {
+    bs::scene_options_t options;
+
+    options.size = cv::Size (96, 72);
+    options.sprites = 2;
+    options.flicker = options.waving = 1;
+
+    return bs::scene_t (options).frames (n);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+struct runner_t {
+    std::shared_ptr< bs::detail::base_t > model;
+    std::function< void (const cv::Mat&) > update;
+};
+
+template< typename Model, typename ... Args >
+static runner_t
+runner_from (Args&& ... args) {
+    auto p = std::make_shared< Model > (std::forward< Args > (args)...);
+    return { p, [p](const cv::Mat& frame) { (*p) (frame); } };
+}
+
+template< typename Model >
+static runner_t
+approximate_from (const cv::Mat& b) {
+    auto p = std::make_shared< Model > (bs::float_from (b));
+    p->approximate (true);
+
+    return { p, [p](const cv::Mat& frame) { (*p) (frame); } };
+}
+
+//
+// A model under test, the fixtures it is checked against, the conversion of
+// the frames to its input, and the tolerances of its outputs: the least
+// intersection over union of the masks and the largest error of the
+// background, relative to its range. The models computing in integers are
+// exact; the ones computing in floating point tolerate the differences of
+// contraction and vectorization, and the fuzzy integrals the blending with the
+// similarity range of the previous frame, which the original code computed
+// over the current one (see src/fuzzy_integral.hpp); the approximate
+// reciprocals are checked against the fixtures of the exact ones:
+//
+struct model_case_t {
+    std::string name, fixture;
+    std::function< cv::Mat (const cv::Mat&) > prepare;
+    std::function< runner_t (const cv::Mat&) > make;
+    double iou, error;
+};
+
+static cv::Mat
+as_is (const cv::Mat& frame) {
+    return frame;
+}
+
+static cv::Mat
+as_gray (const cv::Mat& frame) {
+    return bs::gray_from (frame);
+}
+
+static const std::vector< model_case_t >&
+model_cases () {
+    static const std::vector< model_case_t > cases {
+        { "adaptive_median", "adaptive_median", as_gray, [](const cv::Mat& b) {
+                return runner_from< bs::adaptive_median_t > (b, 10, 15); },
+          1., 0. },
+
+        { "fgmm_um", "fgmm_um", as_is, [](const cv::Mat&) {
+                return runner_from< bs::fgmm_um_t > (); }, .98, .01 },
+
+        { "fgmm_uv", "fgmm_uv", as_is, [](const cv::Mat&) {
+                return runner_from< bs::fgmm_uv_t > (); }, .98, .01 },
+
+        { "fuzzy_choquet", "fuzzy_choquet", as_is, [](const cv::Mat& b) {
+                return runner_from< bs::fuzzy_choquet_t > (
+                    bs::float_from (b)); }, .98, .01 },
+
+        { "fuzzy_choquet_approximate", "fuzzy_choquet", as_is,
+          approximate_from< bs::fuzzy_choquet_t >, .98, .01 },
+
+        { "fuzzy_sugeno", "fuzzy_sugeno", as_is, [](const cv::Mat& b) {
+                return runner_from< bs::fuzzy_sugeno_t > (
+                    bs::float_from (b)); }, .9, .02 },
+
+        { "fuzzy_sugeno_approximate", "fuzzy_sugeno", as_is,
+          approximate_from< bs::fuzzy_sugeno_t >, .9, .02 },
+
+        { "grimson_gmm", "grimson_gmm", as_is, [](const cv::Mat&) {
+                return runner_from< bs::grimson_gmm_t > (); }, .98, .01 },
+
+        { "sigma_delta", "sigma_delta", as_gray, [](const cv::Mat& b) {
+                return runner_from< bs::sigma_delta_t > (b); }, 1., 0. },
+
+        { "simple_gaussian", "simple_gaussian", as_is, [](const cv::Mat& b) {
+                return runner_from< bs::simple_gaussian_t > (b); }, .98, .01 },
+
+        { "temporal_median", "temporal_median", as_gray, [](const cv::Mat& b) {
+                return runner_from< bs::temporal_median_t > (b); }, 1., 0. },
+
+        { "zivkovic_gmm", "zivkovic_gmm", as_is, [](const cv::Mat&) {
+                return runner_from< bs::zivkovic_gmm_t > (); }, .98, .01 }
+    };
+
+    return cases;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// The masks and backgrounds of a model at a few frames of the sequence:
+//
+struct outputs_t {
+    std::vector< cv::Mat > masks, backgrounds;
+};
+
+static const size_t frame_count = 48;
+static const size_t checkpoints [] = { 15, 31, 47 };
+
+static outputs_t
+run (const model_case_t& c, const std::vector< cv::Mat >& frames,
+     const bs::execution_t& execution = { }) {
+    std::vector< cv::Mat > xs;
+
+    for (const auto& frame : frames)
+        xs.push_back (c.prepare (frame));
+
+    runner_t runner = c.make (xs [0]);
+    runner.model->execution (execution);
+
+    outputs_t outputs;
+
+    for (size_t i = 0, j = 0; i < xs.size (); ++i) {
+        runner.update (xs [i]);
+
+        if (j < sizeof checkpoints / sizeof *checkpoints && i == checkpoints [j]) {
+            outputs.masks.push_back (runner.model->mask ().clone ());
+            outputs.backgrounds.push_back (runner.model->background ().clone ());
+            ++j;
+        }
+    }
+
+    return outputs;
+}
+
+static double
+iou (const cv::Mat& a, const cv::Mat& b) {
+    const int u = cv::countNonZero (a | b);
+    return u ? double (cv::countNonZero (a & b)) / u : 1.;
+}
+
+static double
+range_of (const cv::Mat& x) {
+    switch (x.depth ()) {
+    case CV_8U:  return 255.;
+    case CV_16U: return 65535.;
+    default:
+        return 1.;
+    }
+}
+
+//
+// The largest difference of two backgrounds, relative to their range:
+//
+static double
+max_error (const cv::Mat& a, const cv::Mat& b) {
+    if (a.empty () && b.empty ())
+        return 0.;
+
+    BS_ASSERT (a.size () == b.size () && a.type () == b.type ());
+    return cv::norm (a, b, cv::NORM_INF) / range_of (a);
+}
+
+static void
+check (const model_case_t& c, const outputs_t& lhs, const outputs_t& rhs) {
+    BOOST_TEST_REQUIRE (lhs.masks.size () == rhs.masks.size ());
+
+    for (size_t i = 0; i < lhs.masks.size (); ++i) {
+        BOOST_TEST_CONTEXT (c.name << ", frame " << checkpoints [i]) {
+            BOOST_TEST (iou (lhs.masks [i], rhs.masks [i]) >= c.iou);
+
+            BOOST_TEST (
+                max_error (lhs.backgrounds [i], rhs.backgrounds [i]) <= c.error);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// The fixtures keep the floating point backgrounds, in [0, 1], as 16-bit
+// images:
+//
+static cv::Mat
+to_fixture (const cv::Mat& x) {
+    if (x.depth () == CV_8U || x.depth () == CV_16U)
+        return x;
+
+    cv::Mat y;
+    x.convertTo (y, CV_16U, 65535.);
+
+    return y;
+}
+
+static std::string
+fixture_path (const std::string& name, const char* what, size_t frame) {
+    char buf [64];
+    snprintf (buf, sizeof buf, "/%s_%03zu.png", what, frame);
+
+    return std::string (BS_FIXTURES_DIR) + "/" + name + buf;
+}
+
+static bool
+recording () {
+    const char* s = getenv ("BS_RECORD_FIXTURES");
+    return s && s [0] && s [0] != '0';
+}
+
+static void
+record (const model_case_t& c, const outputs_t& outputs) {
+    mkdir (BS_FIXTURES_DIR, 0755);
+    mkdir ((std::string (BS_FIXTURES_DIR) + "/" + c.fixture).c_str (), 0755);
+
+    const std::vector< int > params { cv::IMWRITE_PNG_COMPRESSION, 9 };
+
+    for (size_t i = 0; i < outputs.masks.size (); ++i) {
+        const size_t frame = checkpoints [i];
+
+        BOOST_TEST_REQUIRE (cv::imwrite (
+            fixture_path (c.fixture, "mask", frame), outputs.masks [i], params));
+
+        BOOST_TEST_REQUIRE (cv::imwrite (
+            fixture_path (c.fixture, "background", frame),
+            to_fixture (outputs.backgrounds [i]), params));
+    }
+
+    BOOST_TEST_MESSAGE ("recorded the fixtures of " << c.fixture);
+}
+
+//
+// The fixtures of a model, if all of them are there:
+//
+static bool
+load (const model_case_t& c, outputs_t& outputs) {
+    for (size_t frame : checkpoints) {
+        const cv::Mat mask = cv::imread (
+            fixture_path (c.fixture, "mask", frame), cv::IMREAD_UNCHANGED);
+
+        const cv::Mat background = cv::imread (
+            fixture_path (c.fixture, "background", frame), cv::IMREAD_UNCHANGED);
+
+        if (mask.empty () || background.empty ())
+            return false;
+
+        outputs.masks.push_back (mask);
+        outputs.backgrounds.push_back (background);
+    }
+
+    return true;
+}
+
+//
+// The outputs of a model against its fixtures:
+//
+static void
+check_fixtures (const model_case_t& c, const outputs_t& outputs) {
+    outputs_t expected;
+
+    BOOST_TEST_REQUIRE (
+        load (c, expected), "missing fixtures of " << c.fixture
+        << " in " BS_FIXTURES_DIR);
+
+    outputs_t actual;
+
+    for (size_t i = 0; i < outputs.masks.size (); ++i) {
+        actual.masks.push_back (outputs.masks [i]);
+        actual.backgrounds.push_back (to_fixture (outputs.backgrounds [i]));
+    }
+
+    check (c, actual, expected);
+}
+
+//
+// The LBP of the original code, one pixel at a time:
+//
+template< typename T >
+static cv::Mat
+reference_lbp (const cv::Mat& src, T off) {
+    cv::Mat dst (src.size (), src.type (), cv::Scalar (0));
+
+    for (int i = 1; i < src.rows - 1; ++i) {
+        for (int j = 1; j < src.cols - 1; ++j) {
+            const auto at = [&](int di, int dj) {
+                return src.at< T > (i + di, j + dj);
+            };
+
+            const T t = at (0, 0) + off;
+
+            dst.at< T > (i, j) =
+                ((at (-1, -1) >= t) << 7) +
+                ((at (-1,  0) >= t) << 6) +
+                ((at (-1,  1) >= t) << 5) +
+                ((at ( 0, -1) >= t)) +
+                ((at ( 0,  1) >= t) << 4) +
+                ((at ( 1, -1) >= t) << 1) +
+                ((at ( 1,  0) >= t) << 2) +
+                ((at ( 1,  1) >= t) << 3);
+        }
+    }
+
+    return dst;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE (golden) {
+    const auto frames = make_sequence (frame_count);
+
+    for (const auto& c : model_cases ()) {
+        const auto outputs = run (c, frames);
+
+        if (recording ()) {
+            if (c.fixture == c.name)
+                record (c, outputs);
+
+            continue;
+        }
+
+        check_fixtures (c, outputs);
+    }
+}
+
+//
+// Every tier the host has, from the scalar code the compiler emits for plain
+// x86-64 up, against the fixtures:
+//
+BOOST_AUTO_TEST_CASE (tiers) {
+    if (recording ())
+        return;
+
+    const auto frames = make_sequence (frame_count);
+
+    const cv::Mat x = bs::gray_from (frames [0]), y = bs::float_from (x);
+
+    const bs::cpu_tier_t host = bs::cpu_tier ();
+
+    for (auto tier : {
+            bs::CPU_SSE2, bs::CPU_SSE41, bs::CPU_AVX2, bs::CPU_AVX512 }) {
+        if (tier > host)
+            break;
+
+        bs::cpu_tier (tier);
+
+        BOOST_TEST_CONTEXT (bs::cpu_tier_name (tier)) {
+            BOOST_TEST (0. == cv::norm (
+                            reference_lbp< unsigned char > (x, 0), bs::lbp (x),
+                            cv::NORM_INF));
+
+            BOOST_TEST (0. == cv::norm (
+                            reference_lbp< float > (y, 1.f / 255), bs::lbp (y),
+                            cv::NORM_INF));
+
+            for (const auto& c : model_cases ())
+                check_fixtures (c, run (c, frames));
+        }
+    }
+
+    bs::cpu_tier (host);
+}
+
+//
+// The parallel loops on one thread, against the fixtures:
+//
+BOOST_AUTO_TEST_CASE (threads) {
+    if (recording ())
+        return;
+
+    const auto frames = make_sequence (frame_count);
+
+    bs::execution_t one;
+    one.threads = 1;
+
+    for (const auto& c : model_cases ())
+        check_fixtures (c, run (c, frames, one));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,96 @@
+// -*- mode: c++ -*-
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE scene
+
+#include <bs/scene.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(scene)
+
+static bs::scene_options_t
+make_options () {
+    bs::scene_options_t options;
+
+    options.size = cv::Size (128, 96);
+    options.frames = 20;
+    options.flicker = options.waving = 1;
+
+    return options;
+}
+
+static bool
+equal (const cv::Mat& a, const cv::Mat& b) {
+    return a.size () == b.size () && a.type () == b.type () &&
+        0. == cv::norm (a, b, cv::NORM_INF);
+}
+
+BOOST_AUTO_TEST_CASE (deterministic) {
+    bs::scene_t a (make_options ()), b (make_options ());
+
+    cv::Mat x, y, m, n;
+
+    for (size_t t : { 0, 7, 19 }) {
+        a.render (t, x, m);
+        b.render (t, y, n);
+
+        BOOST_TEST (equal (x, y));
+        BOOST_TEST (equal (m, n));
+    }
+
+    //
+    // Another seed, another scene:
+    //
+    auto options = make_options ();
+    options.seed = 2;
+
+    bs::scene_t (options).render (7, y, n);
+    a.render (7, x, m);
+
+    BOOST_TEST (!equal (x, y));
+}
+
+BOOST_AUTO_TEST_CASE (frames) {
+    bs::scene_t scene (make_options ());
+
+    std::vector< cv::Mat > frames;
+
+    for (cv::Mat frame, mask; scene.next (frame, mask); ) {
+        BOOST_TEST (frame.type () == CV_8UC3);
+        BOOST_TEST (mask.type () == CV_8U);
+
+        frames.push_back (frame.clone ());
+    }
+
+    BOOST_TEST (frames.size () == 20UL);
+    BOOST_TEST (equal (frames [5], bs::scene_t (make_options ()).frames (6) [5]));
+}
+
+BOOST_AUTO_TEST_CASE (ground_truth) {
+    auto options = make_options ();
+
+    options.drift = 0;
+    options.noise = 0;
+    options.flicker = options.waving = 0;
+
+    bs::scene_t scene (options);
+
+    cv::Mat frame, mask;
+    scene.render (3, frame, mask);
+
+    //
+    // The sprites are in the mask; without drift, noise or multimodal regions
+    // the frame is the background everywhere else:
+    //
+    BOOST_TEST (0 < cv::countNonZero (mask));
+
+    cv::Mat background = scene.background ().clone ();
+    frame.copyTo (background, mask);
+
+    BOOST_TEST (equal (frame, background));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
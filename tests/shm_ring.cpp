@@ -0,0 +1,314 @@
+// -*- mode: c++ -*-
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE shm_ring
+
+#include <bs/shm_ring.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+BOOST_AUTO_TEST_SUITE(shm_ring)
+
+using clock_type = std::chrono::steady_clock;
+
+static std::string
+ring_name (const char* what) {
+    return std::string ("/bs-test-") + what + "-" + std::to_string (getpid ());
+}
+
+static void
+sleep_ms (int n) {
+    std::this_thread::sleep_for (std::chrono::milliseconds (n));
+}
+
+//
+// Frame i of a stream, of a size varying with i, filled with i:
+//
+static cv::Mat
+make_frame (int i) {
+    return cv::Mat (8 + i % 5, 16 + i % 7, CV_8UC3, cv::Scalar::all (i % 256));
+}
+
+static bool
+is_frame (const cv::Mat& frame, int i) {
+    const cv::Mat expected = make_frame (i);
+
+    return frame.size () == expected.size () &&
+        frame.type () == expected.type () &&
+        0 == cv::norm (frame, expected, cv::NORM_INF);
+}
+
+//
+// Runs a writer in a child process; the child signals through a pipe once the
+// ring is created, and exits with the status the function returns:
+//
+static pid_t
+fork_writer (const std::string& name, size_t slots,
+             std::function< int (bs::shm_writer_t&) > f) {
+    int fds [2];
+    BOOST_TEST_REQUIRE (0 == pipe (fds));
+
+    const pid_t pid = fork ();
+    BOOST_TEST_REQUIRE (0 <= pid);
+
+    if (0 == pid) {
+        ::close (fds [0]);
+
+        int status = 1;
+
+        try {
+            bs::shm_writer_t writer (name, slots, 64 * 64 * 3);
+
+            const char c = 0;
+
+            if (1 == write (fds [1], &c, 1))
+                status = f (writer);
+        }
+        catch (...) { }
+
+        _exit (status);
+    }
+
+    ::close (fds [1]);
+
+    char c;
+    BOOST_TEST_REQUIRE (1 == read (fds [0], &c, 1));
+
+    ::close (fds [0]);
+
+    return pid;
+}
+
+static int
+exit_status (pid_t pid) {
+    int status = 0;
+    BOOST_TEST_REQUIRE (pid == waitpid (pid, &status, 0));
+
+    return WIFEXITED (status) ? WEXITSTATUS (status) : -1;
+}
+
+BOOST_AUTO_TEST_CASE (stream) {
+    const auto name = ring_name ("stream");
+
+    //
+    // More frames than slots, for the indices to wrap around the ring:
+    //
+    const pid_t pid = fork_writer (name, 3, [](bs::shm_writer_t& writer) {
+        for (int i = 0; i < 50; ++i)
+            writer << make_frame (i);
+
+        writer.close ();
+        return 0;
+    });
+
+    bs::shm_reader_t reader (name);
+
+    int n = 0;
+
+    for (cv::Mat frame; reader.read (frame); ++n)
+        BOOST_TEST (is_frame (frame, n));
+
+    BOOST_TEST (50 == n);
+    BOOST_TEST (0 == exit_status (pid));
+}
+
+//
+// A slow reader fills the ring, the writer blocks until slots are released:
+//
+BOOST_AUTO_TEST_CASE (full) {
+    const auto name = ring_name ("full");
+
+    const pid_t pid = fork_writer (name, 2, [](bs::shm_writer_t& writer) {
+        bool blocked = false;
+
+        for (int i = 0; i < 8; ++i) {
+            const auto t = clock_type::now ();
+            writer << make_frame (i);
+
+            blocked = blocked ||
+                clock_type::now () - t > std::chrono::milliseconds (10);
+        }
+
+        writer.close ();
+        return blocked ? 0 : 2;
+    });
+
+    bs::shm_reader_t reader (name);
+
+    int n = 0;
+
+    for (cv::Mat frame; sleep_ms (20), reader.read (frame); ++n)
+        BOOST_TEST (is_frame (frame, n));
+
+    BOOST_TEST (8 == n);
+    BOOST_TEST (0 == exit_status (pid));
+}
+
+//
+// A slow writer leaves the ring empty, the reader blocks until a frame is
+// published, or the stream closed:
+//
+BOOST_AUTO_TEST_CASE (empty) {
+    const auto name = ring_name ("empty");
+
+    const pid_t pid = fork_writer (name, 4, [](bs::shm_writer_t& writer) {
+        for (int i = 0; i < 4; ++i) {
+            sleep_ms (20);
+            writer << make_frame (i);
+        }
+
+        sleep_ms (20);
+        writer.close ();
+
+        return 0;
+    });
+
+    bs::shm_reader_t reader (name);
+
+    int n = 0;
+    bool blocked = false;
+
+    for (cv::Mat frame; ; ++n) {
+        const auto t = clock_type::now ();
+
+        if (!reader.read (frame))
+            break;
+
+        blocked = blocked ||
+            clock_type::now () - t > std::chrono::milliseconds (10);
+
+        BOOST_TEST (is_frame (frame, n));
+    }
+
+    BOOST_TEST (4 == n);
+    BOOST_TEST (blocked);
+    BOOST_TEST (0 == exit_status (pid));
+}
+
+//
+// A writer that dies without closing the stream ends it, once the frames it
+// published are read; it is not reaped before, a zombie is gone all the same:
+//
+BOOST_AUTO_TEST_CASE (writer_gone) {
+    const auto name = ring_name ("writer-gone");
+
+    const pid_t pid = fork_writer (name, 4, [](bs::shm_writer_t& writer) {
+        for (int i = 0; i < 3; ++i)
+            writer << make_frame (i);
+
+        raise (SIGKILL);
+        return 0;
+    });
+
+    bs::shm_reader_t reader (name);
+
+    int n = 0;
+
+    for (cv::Mat frame; reader.read (frame); ++n)
+        BOOST_TEST (is_frame (frame, n));
+
+    BOOST_TEST (3 == n);
+    BOOST_TEST (-1 == exit_status (pid));
+
+    shm_unlink (name.c_str ());
+}
+
+//
+// A reader that dies leaves the writer of a full ring with a broken pipe:
+//
+BOOST_AUTO_TEST_CASE (reader_gone) {
+    const auto name = ring_name ("reader-gone");
+
+    bs::shm_writer_t writer (name, 2, 64 * 64 * 3);
+
+    int fds [2];
+    BOOST_TEST_REQUIRE (0 == pipe (fds));
+
+    const pid_t pid = fork ();
+    BOOST_TEST_REQUIRE (0 <= pid);
+
+    if (0 == pid) {
+        ::close (fds [0]);
+
+        bs::shm_reader_t reader (name);
+
+        const char c = 0;
+        cv::Mat frame;
+
+        if (reader.read (frame) && 1 == write (fds [1], &c, 1))
+            raise (SIGKILL);
+
+        _exit (1);
+    }
+
+    ::close (fds [1]);
+
+    writer << make_frame (0);
+
+    char c;
+    BOOST_TEST_REQUIRE (1 == read (fds [0], &c, 1));
+
+    ::close (fds [0]);
+
+    BOOST_CHECK_EXCEPTION (
+        for (int i = 1; i < 8; ++i) writer << make_frame (i),
+        std::system_error, [](const std::system_error& e) {
+            return EPIPE == e.code ().value ();
+        });
+
+    BOOST_TEST (-1 == exit_status (pid));
+}
+
+//
+// One reader at a time, the place of a detached one is free:
+//
+BOOST_AUTO_TEST_CASE (busy) {
+    const auto name = ring_name ("busy");
+
+    bs::shm_writer_t writer (name, 2, 64);
+
+    {
+        bs::shm_reader_t reader (name);
+        BOOST_CHECK_THROW (bs::shm_reader_t { name }, std::system_error);
+    }
+
+    bs::shm_reader_t reader (name);
+}
+
+//
+// The segment of a writer that died is replaced, the one of a live writer is
+// not:
+//
+BOOST_AUTO_TEST_CASE (stale) {
+    const auto name = ring_name ("stale");
+
+    const pid_t pid = fork ();
+    BOOST_TEST_REQUIRE (0 <= pid);
+
+    if (0 == pid) {
+        new bs::shm_writer_t (name, 2, 64);
+        _exit (0);
+    }
+
+    BOOST_TEST_REQUIRE (0 == exit_status (pid));
+
+    {
+        bs::shm_writer_t writer (name, 2, 64);
+        BOOST_CHECK_THROW (bs::shm_writer_t (name, 2, 64), std::system_error);
+    }
+
+    BOOST_TEST (0 > shm_unlink (name.c_str ()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE unique_resource
 
+#include <bs/cpu.hpp>
 #include <bs/utils.hpp>
 
 #include <boost/format.hpp>
@@ -61,4 +62,26 @@ BOOST_AUTO_TEST_CASE (threshold_test) {
     }
 }
 
+BOOST_AUTO_TEST_CASE (threshold_tiers_test) {
+    cv::Mat x (64, 67, CV_16U);
+    cv::randu (x, 0, 65536);
+
+    const auto host = bs::cpu_tier ();
+
+    bs::cpu_tier (bs::CPU_SSE2);
+    const cv::Mat y = bs::threshold (x, 32768, 1000, CV_THRESH_BINARY);
+
+    //
+    // Every tier the host has computes the same:
+    //
+    for (auto tier : { bs::CPU_SSE41, bs::CPU_AVX2, bs::CPU_AVX512 }) {
+        bs::cpu_tier (tier);
+
+        const cv::Mat z = bs::threshold (x, 32768, 1000, CV_THRESH_BINARY);
+        BOOST_TEST (0 == cv::norm (y, z, cv::NORM_INF));
+    }
+
+    bs::cpu_tier (host);
+}
+
 BOOST_AUTO_TEST_SUITE_END()